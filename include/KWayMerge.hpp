@@ -0,0 +1,296 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* K-way merge header.
+*
+* LoserTree merges k sorted ranges one element at a time.
+* Every internal node of the tree keeps the range that lost the match played there, and the root keeps the overall winner.
+* After taking the winner only its path to the root is replayed, so every element costs ceil(log2(k)) matches.
+* Elements that compare equal are taken from the range that comes first, so the merge is stable.
+* Small trivially copyable elements are cached in the tree, one per range, so the matches compare values of a contiguous array instead of following the iterators of every range.
+* Their matches are played without branches, which costs two comparisons instead of one but no mispredictions, as the winner of a match on random data is a coin flip.
+*
+* KWayMerge::Merge writes the merged ranges to any output iterator, so the result can be streamed without keeping it in memory.
+* KWayMerge::ParallelMerge splits the work between the threads of a SortThreadPool:
+* splitter values are sampled from the ranges and the rank of each splitter in every range gives both where to split that range and where its part starts in the output.
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include <algorithm>    //For std::lower_bound, std::min, std::max and std::swap
+#include <iterator>     //For std::next, std::distance and std::iterator_traits
+#include <type_traits>  //For std::is_trivially_copyable_v and std::is_default_constructible_v
+#include <utility>      //For std::pair
+#include <vector>       //For std::vector
+
+#include "Sort.hpp"
+
+template<typename Iterator, typename Comparator>
+class LoserTree
+{
+    using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+
+public:
+    bool Empty() const noexcept { return m_Exhausted[m_Tree[0]] != 0; }
+
+    //Next element of the merge. The tree can not be empty.
+    Iterator Top() const noexcept { return m_Heads[m_Tree[0]]; }
+
+    //Takes the next element of the merge and replays the matches of its range.
+    void Pop() noexcept
+    {
+        size_t winner = m_Tree[0];
+        std::advance(m_Heads[winner], 1);
+        m_Exhausted[winner] = m_Heads[winner] == m_Ends[winner];
+        if constexpr (s_CacheKeys)
+        {
+            if (m_Exhausted[winner]) { Replay(winner); return; }
+
+            //The key of the winner stays in a register while it climbs. The loser wins if it goes first, or if it is equal and its range comes first.
+            IteratorType key = *m_Heads[winner];
+            m_Keys[winner] = key;
+            for (size_t node = (winner + m_Size) / 2; node > 0; node /= 2)
+            {
+                const size_t loser = m_Tree[node];
+                const IteratorType loser_key = m_Keys[loser];
+                const bool loser_first = m_Comparator(key, loser_key);
+                const bool winner_first = m_Comparator(loser_key, key);
+                const bool beats = (m_Exhausted[loser] == 0) & (loser_first | ((winner_first == false) & (loser < winner)));
+                m_Tree[node] = beats ? winner : loser;
+                winner = beats ? loser : winner;
+                key = beats ? loser_key : key;
+            }
+            m_Tree[0] = winner;
+        }
+        else
+        {
+            Replay(winner);
+        }
+    }
+
+public:
+    LoserTree(const std::vector<std::pair<Iterator, Iterator>>& ranges, Comparator comparator) noexcept :
+        m_Comparator(comparator),
+        m_Size(ranges.empty() ? 1 : ranges.size())
+    {
+        m_Heads.reserve(m_Size);
+        m_Ends.reserve(m_Size);
+        for (const std::pair<Iterator, Iterator>& range : ranges)
+        {
+            m_Heads.push_back(range.first);
+            m_Ends.push_back(range.second);
+        }
+        if (ranges.empty())
+        {
+            m_Heads.emplace_back();
+            m_Ends.push_back(m_Heads.back());
+        }
+        m_Exhausted.reserve(m_Size);
+        for (size_t i = 0; i < m_Size; ++i)
+        {
+            m_Exhausted.push_back(m_Heads[i] == m_Ends[i]);
+        }
+        if constexpr (s_CacheKeys)
+        {
+            m_Keys.reserve(m_Size);
+            for (size_t i = 0; i < m_Size; ++i)
+            {
+                m_Keys.push_back(m_Heads[i] != m_Ends[i] ? IteratorType(*m_Heads[i]) : IteratorType());
+            }
+        }
+
+        //The leaves are the nodes [m_Size, 2 * m_Size). Each internal node plays the winners of its children.
+        m_Tree.resize(m_Size, 0);
+        std::vector<size_t> winners(2 * m_Size, 0);
+        for (size_t i = 0; i < m_Size; ++i)
+        {
+            winners[m_Size + i] = i;
+        }
+        for (size_t node = m_Size - 1; node > 0; --node)
+        {
+            const size_t left = winners[2 * node];
+            const size_t right = winners[2 * node + 1];
+            const bool left_wins = Beats(left, right);
+            winners[node] = left_wins ? left : right;
+            m_Tree[node] = left_wins ? right : left;
+        }
+        m_Tree[0] = winners[1];
+    }
+
+private:
+    //Plays the matches of the range from its leaf to the root.
+    void Replay(size_t winner) noexcept
+    {
+        for (size_t node = (winner + m_Size) / 2; node > 0; node /= 2)
+        {
+            if (Beats(m_Tree[node], winner)) { std::swap(m_Tree[node], winner); }
+        }
+        m_Tree[0] = winner;
+    }
+
+    //Exhausted ranges lose every match. On ties, the range that comes first wins.
+    bool Beats(size_t first, size_t second) const noexcept
+    {
+        if (m_Exhausted[first]) { return false; }
+        if (m_Exhausted[second]) { return true; }
+        if (first < second) { return !m_Comparator(Key(first), Key(second)); }
+        return m_Comparator(Key(second), Key(first));
+    }
+
+    //Current element of the range, which must not be exhausted.
+    decltype(auto) Key(size_t range) const noexcept
+    {
+        if constexpr (s_CacheKeys) { return m_Keys[range]; }
+        else { return *m_Heads[range]; }
+    }
+
+private:
+    Comparator m_Comparator;
+    size_t m_Size;
+    std::vector<Iterator> m_Heads;  //Current element of every range.
+    std::vector<Iterator> m_Ends;
+    std::vector<size_t> m_Tree;     //Loser of every internal node and winner in position 0.
+    std::vector<IteratorType> m_Keys;   //Copy of the current element of every range that is not exhausted, only if s_CacheKeys.
+    std::vector<unsigned char> m_Exhausted; //Ranges without elements left, so the matches do not compare iterators.
+
+    static constexpr bool s_CacheKeys = std::is_trivially_copyable_v<IteratorType> && std::is_default_constructible_v<IteratorType> && sizeof(IteratorType) <= 2 * sizeof(void*);
+};
+
+class KWayMerge
+{
+public:
+    /*
+    * Writes the merge of the sorted ranges to output and returns the output iterator past the last element written.
+    * The elements are copied. Pass std::move_iterator ranges to move them instead.
+    */
+    template<typename Iterator, typename OutputIterator, typename Comparator>
+    static OutputIterator Merge(const std::vector<std::pair<Iterator, Iterator>>& ranges, OutputIterator output, Comparator comparator) noexcept
+    {
+        LoserTree<Iterator, Comparator> tree(ranges, comparator);
+        for (; !tree.Empty(); tree.Pop())
+        {
+            *output = *tree.Top();
+            ++output;
+        }
+        return output;
+    }
+
+    /*
+    * Merges the sorted ranges to the random access output splitting the work in parts sorted by the pool threads and the calling thread.
+    * Returns the output iterator past the last element written.
+    */
+    template<typename Iterator, typename OutputIterator, typename Comparator>
+    static OutputIterator ParallelMerge(const std::vector<std::pair<Iterator, Iterator>>& ranges, OutputIterator output, Comparator comparator, SortThreadPool& pool) noexcept
+    {
+        using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+
+        size_t total_size = 0;
+        for (const std::pair<Iterator, Iterator>& range : ranges)
+        {
+            total_size += std::distance(range.first, range.second);
+        }
+        const size_t parts = std::min(pool.GetThreadCount() + 1, std::max<size_t>(total_size / s_MinPartSize, 1));
+        if (parts == 1) { return Merge(ranges, output, comparator); }
+
+        //Evenly spaced samples of every range, sorted to choose parts - 1 splitters.
+        std::vector<Iterator> samples;
+        for (const std::pair<Iterator, Iterator>& range : ranges)
+        {
+            const size_t size = std::distance(range.first, range.second);
+            const size_t count = (s_SamplesPerPart * parts * size + total_size - 1) / total_size;
+            for (size_t i = 0; i < count && size != 0; ++i)
+            {
+                samples.push_back(std::next(range.first, (2 * i + 1) * size / (2 * count)));
+            }
+        }
+        const auto sample_comparator = [&](const Iterator& first, const Iterator& second) { return comparator(*first, *second); };
+        Sort(samples.begin(), samples.end(), sample_comparator);
+
+        //Split point of every range for every part boundary. Elements equal to a splitter go to the part on its right in every range.
+        MergeJob<Iterator, OutputIterator, Comparator> job{ &ranges, output, comparator, std::vector<std::vector<Iterator>>(parts + 1), std::vector<size_t>(parts + 1, 0) };
+        job.Splits[0].reserve(ranges.size());
+        job.Splits[parts].reserve(ranges.size());
+        for (const std::pair<Iterator, Iterator>& range : ranges)
+        {
+            job.Splits[0].push_back(range.first);
+            job.Splits[parts].push_back(range.second);
+        }
+        job.Offsets[parts] = total_size;
+        for (size_t part = 1; part < parts; ++part)
+        {
+            const IteratorType& splitter = *samples[part * samples.size() / parts];
+            for (size_t i = 0; i < ranges.size(); ++i)
+            {
+                const Iterator split = std::lower_bound(job.Splits[part - 1][i], ranges[i].second, splitter,
+                    [&](const IteratorType& element, const IteratorType& value) { return comparator(value, element); });
+                job.Splits[part].push_back(split);
+                job.Offsets[part] += std::distance(ranges[i].first, split);
+            }
+        }
+
+        SortThreadPool::TaskGroup group;
+        for (size_t part = 1; part < parts; ++part)
+        {
+            pool.Submit(group, &MergeTask<Iterator, OutputIterator, Comparator>, &job, part, 0);
+        }
+        MergeTask<Iterator, OutputIterator, Comparator>(&job, 0, 0);
+        pool.Wait(group);
+
+        return std::next(output, total_size);
+    }
+
+private:
+    template<typename Iterator, typename OutputIterator, typename Comparator>
+    struct MergeJob
+    {
+        const std::vector<std::pair<Iterator, Iterator>>* Ranges;
+        OutputIterator Output;
+        Comparator Compare;
+        std::vector<std::vector<Iterator>> Splits;  //Splits[part][range] is where the range starts in that part.
+        std::vector<size_t> Offsets;                //Offsets[part] is where that part starts in the output.
+    };
+
+    template<typename Iterator, typename OutputIterator, typename Comparator>
+    static void MergeTask(void* context, size_t part, size_t) noexcept
+    {
+        const MergeJob<Iterator, OutputIterator, Comparator>& job = *static_cast<const MergeJob<Iterator, OutputIterator, Comparator>*>(context);
+        std::vector<std::pair<Iterator, Iterator>> ranges;
+        ranges.reserve(job.Ranges->size());
+        for (size_t i = 0; i < job.Ranges->size(); ++i)
+        {
+            ranges.emplace_back(job.Splits[part][i], job.Splits[part + 1][i]);
+        }
+        Merge(ranges, std::next(job.Output, job.Offsets[part]), job.Compare);
+    }
+
+private:
+    static constexpr size_t s_MinPartSize = size_t(1) << 16;
+    static constexpr size_t s_SamplesPerPart = 16;
+};
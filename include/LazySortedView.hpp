@@ -0,0 +1,227 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* Lazy sorted view header.
+*
+* LazySortedView reads a random access container as if it was sorted, but only sorts the parts that are read.
+* The container starts as a single pending partition. Reading an element partitions the pending partition that contains it with the Quick Sort partition of Sort,
+* which leaves the pivot in its final place, and keeps partitioning the side that contains the element until it is the pivot or its partition is small enough
+* to be sorted by InsertionSort. The other sides are kept as pending partitions, ordered by their position, and are only sorted if they are read later.
+* Reading the first k elements in order costs O(n + k log k) instead of the O(n log n) of sorting the whole container, and reading a single element anywhere costs O(n).
+* Partitions full of duplicates are split with the three-way partition, as Default Sort does.
+*
+* The view sorts the container in place, so the container must not be modified while the view is used.
+* Elements are returned as const references: modifying them would break the order of the elements still to sort.
+*
+* Time complexity:
+* First k elements: O(n + k log k)
+* Worst: O(n^2), the one of Quick Sort.
+* Space complexity: O(log n) for sequential reads, O(number of pending partitions) for random ones.
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include <algorithm>    //For std::lower_bound
+#include <iterator>     //For std::next, std::distance, std::iterator_traits and std::random_access_iterator_tag
+#include <type_traits>  //For std::is_base_of_v
+#include <vector>       //For std::vector
+
+#include "Sort.hpp"
+
+template<typename Iterator, typename Comparator>
+class LazySortedView
+{
+    using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>,
+        "LazySortedView needs random access iterators");
+
+public:
+    //Random access iterator over the view. Dereferencing it sorts the partition of the element it points to.
+    class ViewIterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = IteratorType;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const IteratorType*;
+        using reference = const IteratorType&;
+
+        reference operator*() const noexcept { return (*m_View)[m_Index]; }
+        pointer operator->() const noexcept { return &(*m_View)[m_Index]; }
+        reference operator[](difference_type offset) const noexcept { return (*m_View)[m_Index + offset]; }
+
+        ViewIterator& operator++() noexcept { ++m_Index; return *this; }
+        ViewIterator operator++(int) noexcept { ViewIterator previous = *this; ++m_Index; return previous; }
+        ViewIterator& operator--() noexcept { --m_Index; return *this; }
+        ViewIterator operator--(int) noexcept { ViewIterator previous = *this; --m_Index; return previous; }
+        ViewIterator& operator+=(difference_type offset) noexcept { m_Index += offset; return *this; }
+        ViewIterator& operator-=(difference_type offset) noexcept { m_Index -= offset; return *this; }
+        ViewIterator operator+(difference_type offset) const noexcept { return ViewIterator(m_View, m_Index + offset); }
+        ViewIterator operator-(difference_type offset) const noexcept { return ViewIterator(m_View, m_Index - offset); }
+        difference_type operator-(const ViewIterator& other) const noexcept { return static_cast<difference_type>(m_Index) - static_cast<difference_type>(other.m_Index); }
+
+        bool operator==(const ViewIterator& other) const noexcept { return m_Index == other.m_Index; }
+        bool operator!=(const ViewIterator& other) const noexcept { return m_Index != other.m_Index; }
+        bool operator<(const ViewIterator& other) const noexcept { return m_Index < other.m_Index; }
+        bool operator>(const ViewIterator& other) const noexcept { return m_Index > other.m_Index; }
+        bool operator<=(const ViewIterator& other) const noexcept { return m_Index <= other.m_Index; }
+        bool operator>=(const ViewIterator& other) const noexcept { return m_Index >= other.m_Index; }
+
+    public:
+        ViewIterator() noexcept { }
+        ViewIterator(LazySortedView* view, size_t index) noexcept : m_View(view), m_Index(index) { }
+
+    private:
+        LazySortedView* m_View = nullptr;
+        size_t m_Index = 0;
+    };
+
+public:
+    //Element that would be at index if the container was sorted. Sorts only the pending partition that contains it.
+    const IteratorType& operator[](size_t index) noexcept
+    {
+        if (index >= m_SortedPrefix) { _SortAt(index); }
+        return *std::next(m_Begin, index);
+    }
+
+    //Sorts the first count elements, so reading them does not sort anything.
+    void SortPrefix(size_t count) noexcept
+    {
+        while (m_SortedPrefix < count && m_SortedPrefix < m_Size) { _SortAt(m_SortedPrefix); }
+    }
+
+    size_t GetSize() const noexcept { return m_Size; }
+
+    //Number of elements at the beginning of the container that are already sorted.
+    size_t GetSortedPrefix() const noexcept { return m_SortedPrefix; }
+
+    //Lowercase so the view can be used in range-based for loops.
+    ViewIterator begin() noexcept { return ViewIterator(this, 0); }
+    ViewIterator end() noexcept { return ViewIterator(this, m_Size); }
+
+public:
+    //Uses the configuration stored in the global SortProfile for the element size.
+    LazySortedView(Iterator begin, Iterator end, Comparator comparator) noexcept :
+        LazySortedView(begin, end, comparator, SortProfile::FindGlobal<sizeof(IteratorType)>())
+    {
+    }
+
+    LazySortedView(Iterator begin, Iterator end, Comparator comparator, const SortConfiguration& configuration) noexcept :
+        m_Begin(begin),
+        m_Size(std::distance(begin, end)),
+        m_Comparator(comparator),
+        m_Configuration(configuration),
+        m_Partitioner(end, end, comparator, SortAlgorithm::Default, configuration)
+    {
+        if (m_Size > 1) { m_Pending.push_back({ 0, m_Size - 1 }); }
+        m_SortedPrefix = m_Pending.empty() ? m_Size : 0;
+    }
+
+    LazySortedView(const LazySortedView&) = delete;
+    LazySortedView& operator=(const LazySortedView&) = delete;
+
+private:
+    //Unsorted partition [Left, Right], as offsets from the beginning of the container.
+    struct Partition
+    {
+        size_t Left;
+        size_t Right;
+    };
+
+    //Splits the pending partition that contains index until the element at index is in its final place.
+    void _SortAt(size_t index) noexcept
+    {
+        //The pending partitions are ordered from the last one to the first one, so the one at the back is the first one and sequential reads only touch the back.
+        auto partition = std::lower_bound(m_Pending.begin(), m_Pending.end(), index, [](const Partition& pending, size_t offset) { return pending.Left > offset; });
+        if (partition == m_Pending.end() || partition->Right < index) { return; }
+
+        size_t left = partition->Left;
+        size_t right = partition->Right;
+        size_t position = std::distance(m_Pending.begin(), partition);
+        m_Pending.erase(partition);
+        while (true)
+        {
+            const Iterator left_iterator = std::next(m_Begin, left);
+            const Iterator right_iterator = std::next(m_Begin, right);
+            if (right - left < m_Configuration.LeafCutoff)
+            {
+                m_Partitioner.InsertionSort(left_iterator, std::next(right_iterator), m_Comparator);
+                break;
+            }
+
+            //Same choice as Default Sort: the element after a partition is the pivot that bounded it, and a new pivot equal to it means the partition is full of duplicates.
+            size_t lower = 0;
+            size_t upper = 0;
+            const Iterator pivot = m_Partitioner._SelectPivot(left_iterator, right_iterator, m_Comparator);
+            if (right + 1 != m_Size && !m_Comparator(*std::next(right_iterator), *pivot))
+            {
+                const auto [lower_iterator, upper_iterator] = m_Partitioner._ThreeWayPartition(left_iterator, right_iterator, pivot, m_Comparator);
+                lower = std::distance(m_Begin, lower_iterator);
+                upper = std::distance(m_Begin, upper_iterator);
+            }
+            else
+            {
+                lower = std::distance(m_Begin, m_Partitioner._QuickSortPartition(left_iterator, right_iterator, pivot, m_Comparator));
+                upper = lower + 1;
+            }
+
+            //[lower, upper) is in its final place. The side without index stays pending, after the side with it in the vector.
+            if (index < lower)
+            {
+                if (right + 1 - upper > 1) { m_Pending.insert(std::next(m_Pending.begin(), position++), { upper, right }); }
+                if (lower - left < 2) { break; }
+                right = lower - 1;
+            }
+            else if (index >= upper)
+            {
+                if (lower - left > 1) { m_Pending.insert(std::next(m_Pending.begin(), position), { left, lower - 1 }); }
+                if (right + 1 - upper < 2) { break; }
+                left = upper;
+            }
+            else
+            {
+                if (right + 1 - upper > 1) { m_Pending.insert(std::next(m_Pending.begin(), position++), { upper, right }); }
+                if (lower - left > 1) { m_Pending.insert(std::next(m_Pending.begin(), position), { left, lower - 1 }); }
+                break;
+            }
+        }
+
+        m_SortedPrefix = m_Pending.empty() ? m_Size : m_Pending.back().Left;
+    }
+
+private:
+    Iterator m_Begin;
+    size_t m_Size;
+    Comparator m_Comparator;
+    SortConfiguration m_Configuration;
+    Sort<Iterator, Comparator> m_Partitioner;   //Sort of an empty range, so it does not sort anything. It only lends its partitions and InsertionSort to the view.
+    std::vector<Partition> m_Pending;           //Pending partitions, from the last one to the first one.
+    size_t m_SortedPrefix;
+};
@@ -0,0 +1,286 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* Normalized key header.
+*
+* Sorting on several columns with a comparator that compares them one by one runs a chain of branches in every comparison.
+* KeyEncoder encodes the columns of a record into a NormalizedKey, a fixed number of bytes that compare with memcmp in the same order the columns would.
+* - Unsigned integers are written most significant byte first.
+* - Signed integers have their sign bit flipped, so the negative values come before the positive ones.
+* - Floating point values are written with their sign bit flipped if positive and all their bits inverted if negative, which gives the IEEE 754 total order.
+* - Strings are truncated or padded with zeros to a fixed length, so they compare by that prefix.
+* - Descending columns have all their bytes inverted.
+* Keys are compared with the comparison operators of NormalizedKey, so std::greater<NormalizedKey> sorts them ascending comparing their bytes like memcmp,
+* or with NormalizedKeySort::RadixSort, a most significant byte first radix sort that needs no comparison at all.
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include <array>        //For std::array
+#include <cstdint>      //For std::uint8_t, std::uint16_t, std::uint32_t and std::uint64_t
+#include <cstring>      //For std::memcmp and std::memcpy
+#include <cstdlib>      //For _byteswap_uint64
+#include <iterator>     //For std::next and std::iterator_traits
+#include <algorithm>    //For std::iter_swap
+#include <string_view>  //For std::string_view
+#include <type_traits>  //For std::is_arithmetic_v, std::is_floating_point_v, std::is_signed_v, std::conditional_t, std::decay_t and std::invoke_result_t
+#include <vector>       //For std::vector
+
+#include "Sort.hpp"
+
+enum class KeyOrder : unsigned char
+{
+    Ascending,
+    Descending
+};
+
+template<size_t Width>
+struct NormalizedKey
+{
+    std::array<unsigned char, Width> Bytes{};
+
+    friend bool operator<(const NormalizedKey& first, const NormalizedKey& second) noexcept { return Compare(first, second) < 0; }
+    friend bool operator>(const NormalizedKey& first, const NormalizedKey& second) noexcept { return Compare(first, second) > 0; }
+    friend bool operator==(const NormalizedKey& first, const NormalizedKey& second) noexcept { return first.Bytes == second.Bytes; }
+    friend bool operator!=(const NormalizedKey& first, const NormalizedKey& second) noexcept { return !(first == second); }
+
+    /*
+    * Same result as memcmp, but comparing 8 bytes at a time read as big endian words.
+    * The width is known at compile time, so the loop is unrolled and every word is a single load and byte swap instead of a call to memcmp.
+    * The byte swap assumes a little endian machine, like the x86 and x86_64 platforms the project builds for.
+    */
+    static int Compare(const NormalizedKey& first, const NormalizedKey& second) noexcept
+    {
+        size_t byte = 0;
+        for (; byte + 8 <= Width; byte += 8)
+        {
+            const std::uint64_t first_word = LoadWord(first.Bytes.data() + byte);
+            const std::uint64_t second_word = LoadWord(second.Bytes.data() + byte);
+            if (first_word != second_word) { return first_word < second_word ? -1 : 1; }
+        }
+        for (; byte < Width; ++byte)
+        {
+            if (first.Bytes[byte] != second.Bytes[byte]) { return first.Bytes[byte] < second.Bytes[byte] ? -1 : 1; }
+        }
+        return 0;
+    }
+
+private:
+    static std::uint64_t LoadWord(const unsigned char* bytes) noexcept
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+#if defined(_MSC_VER)
+        return _byteswap_uint64(word);
+#else
+        return __builtin_bswap64(word);
+#endif
+    }
+};
+
+/*
+* Appends the columns of a record to a NormalizedKey, from the most significant to the least significant.
+* The key is cleared on construction. Bytes past the width of the key are dropped, so a key too narrow compares by the prefix of its columns.
+* GetSize returns the number of bytes the columns need, even if it is bigger than the width.
+*/
+template<size_t Width>
+class KeyEncoder
+{
+public:
+    explicit KeyEncoder(NormalizedKey<Width>& key) noexcept :
+        m_Key(key)
+    {
+        m_Key.Bytes.fill(0);
+    }
+
+    template<typename T>
+    KeyEncoder& Add(T value, KeyOrder order = KeyOrder::Ascending) noexcept
+    {
+        static_assert(std::is_arithmetic_v<T> && sizeof(T) <= 8, "Only integers and floating point values up to 8 bytes can be encoded");
+        using UnsignedType = std::conditional_t<sizeof(T) == 1, std::uint8_t, std::conditional_t<sizeof(T) == 2, std::uint16_t,
+            std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>>;
+        constexpr UnsignedType sign_bit = UnsignedType(1) << (sizeof(T) * 8 - 1);
+
+        UnsignedType bits = 0;
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            std::memcpy(&bits, &value, sizeof(T));
+            bits = (bits & sign_bit) != 0 ? static_cast<UnsignedType>(~bits) : static_cast<UnsignedType>(bits | sign_bit);
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            bits = static_cast<UnsignedType>(static_cast<UnsignedType>(value) ^ sign_bit);
+        }
+        else
+        {
+            bits = static_cast<UnsignedType>(value);
+        }
+        if (order == KeyOrder::Descending) { bits = static_cast<UnsignedType>(~bits); }
+
+        for (size_t byte = sizeof(T); byte > 0; --byte)
+        {
+            Put(static_cast<unsigned char>(bits >> ((byte - 1) * 8)));
+        }
+        return *this;
+    }
+
+    //Adds the first length bytes of the string, padded with zeros if it is shorter. Strings that only differ in trailing zeros compare equal.
+    KeyEncoder& Add(std::string_view value, size_t length, KeyOrder order = KeyOrder::Ascending) noexcept
+    {
+        const unsigned char mask = order == KeyOrder::Descending ? 0xFF : 0x00;
+        for (size_t i = 0; i < length; ++i)
+        {
+            const unsigned char byte = i < value.size() ? static_cast<unsigned char>(value[i]) : 0;
+            Put(static_cast<unsigned char>(byte ^ mask));
+        }
+        return *this;
+    }
+
+    size_t GetSize() const noexcept { return m_Size; }
+
+private:
+    void Put(unsigned char byte) noexcept
+    {
+        if (m_Size < Width) { m_Key.Bytes[m_Size] = byte; }
+        ++m_Size;
+    }
+
+private:
+    NormalizedKey<Width>& m_Key;
+    size_t m_Size = 0;
+};
+
+class NormalizedKeySort
+{
+public:
+    /*
+    * Most significant byte first radix sort of the elements by the NormalizedKey returned by the key function.
+    * Each bucket is distributed in place by its next byte, following the cycles of the permutation like American flag sort.
+    * Bytes equal in the whole bucket, like the padding of strings or the high bytes of small integers, are skipped without moving any element.
+    * Buckets of s_InsertionCutoff elements or less are sorted by InsertionSort comparing the remaining bytes with memcmp.
+    * Not stable sort.
+    *
+    * Time complexity: O(n * w), being w the width of the key, but usually only the bytes needed to tell the keys apart are read.
+    * Space complexity: O(w), at most 255 buckets pending to sort for every byte of the key.
+    */
+    template<typename Iterator, typename KeyFunction>
+    static void RadixSort(Iterator begin, Iterator end, KeyFunction key_function) noexcept
+    {
+        using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+        using KeyType = std::decay_t<std::invoke_result_t<KeyFunction, const IteratorType&>>;
+        constexpr size_t width = sizeof(KeyType::Bytes);
+
+        const auto byte_at = [&](Iterator element, size_t byte) { return key_function(*element).Bytes[byte]; };
+
+        std::vector<Bucket> stack;
+        stack.push_back({ 0, static_cast<size_t>(std::distance(begin, end)), 0 });
+        std::array<size_t, 256> heads;
+        std::array<size_t, 256> tails;
+        while (!stack.empty())
+        {
+            const Bucket bucket = stack.back();
+            stack.pop_back();
+            const Iterator left = std::next(begin, bucket.Begin);
+            const Iterator right = std::next(begin, bucket.End);
+
+            if (bucket.End - bucket.Begin <= s_InsertionCutoff)
+            {
+                const size_t byte = bucket.Byte;
+                Sort(left, right, [&](const IteratorType& first, const IteratorType& second)
+                {
+                    return std::memcmp(key_function(first).Bytes.data() + byte, key_function(second).Bytes.data() + byte, width - byte) > 0;
+                }, SortAlgorithm::InsertionSort, SortConfiguration());
+                continue;
+            }
+
+            std::array<size_t, 256> counts{};
+            for (Iterator element = left; element != right; std::advance(element, 1))
+            {
+                ++counts[byte_at(element, bucket.Byte)];
+            }
+
+            if (counts[byte_at(left, bucket.Byte)] == bucket.End - bucket.Begin)
+            {
+                if (bucket.Byte + 1 < width) { stack.push_back({ bucket.Begin, bucket.End, bucket.Byte + 1 }); }
+                continue;
+            }
+
+            size_t offset = bucket.Begin;
+            for (size_t value = 0; value < 256; ++value)
+            {
+                heads[value] = offset;
+                offset += counts[value];
+                tails[value] = offset;
+            }
+
+            //Every element is swapped straight to the next free place of its bucket until the place being filled gets an element that belongs to it.
+            for (size_t value = 0; value < 256; ++value)
+            {
+                while (heads[value] < tails[value])
+                {
+                    const Iterator current = std::next(begin, heads[value]);
+                    size_t current_value = byte_at(current, bucket.Byte);
+                    while (current_value != value)
+                    {
+                        std::iter_swap(current, std::next(begin, heads[current_value]++));
+                        current_value = byte_at(current, bucket.Byte);
+                    }
+                    ++heads[value];
+                }
+            }
+
+            if (bucket.Byte + 1 == width) { continue; }
+            offset = bucket.Begin;
+            for (size_t value = 0; value < 256; ++value)
+            {
+                if (counts[value] > 1) { stack.push_back({ offset, offset + counts[value], bucket.Byte + 1 }); }
+                offset += counts[value];
+            }
+        }
+    }
+
+    //Sorts a container of NormalizedKey.
+    template<typename Iterator>
+    static void RadixSort(Iterator begin, Iterator end) noexcept
+    {
+        using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+        RadixSort(begin, end, [](const IteratorType& key) -> const IteratorType& { return key; });
+    }
+
+private:
+    struct Bucket
+    {
+        size_t Begin;
+        size_t End;
+        size_t Byte;    //Byte of the key that splits this bucket.
+    };
+
+    static constexpr size_t s_InsertionCutoff = 32;
+};
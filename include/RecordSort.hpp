@@ -0,0 +1,113 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* Large record sort header.
+*
+* Sorting big records directly moves each of them O(log n) times.
+* RecordSort extracts the key of every record together with its position and sorts these (key, index) pairs instead.
+* Then it applies the resulting permutation in place following its cycles, so every record is moved once plus one extra move per cycle.
+* Ties between keys are broken by the index, so the result is stable whatever the algorithm used to sort the pairs.
+*
+* Time complexity: the one of the algorithm used to sort the pairs plus O(n) to apply the permutation.
+* Space complexity: O(n) for the pairs.
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include <iterator>     //For std::next, std::distance and std::iterator_traits
+#include <type_traits>  //For std::decay_t and std::invoke_result_t
+#include <utility>      //For std::pair and std::move
+#include <vector>       //For std::vector
+
+#include "Sort.hpp"
+
+/*
+* The key function receives a record and returns its key. The comparator compares two keys like the Sort comparators do.
+*/
+template<typename Iterator, typename KeyFunction, typename KeyComparator>
+class RecordSort
+{
+    using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+    using KeyType = std::decay_t<std::invoke_result_t<KeyFunction, const IteratorType&>>;
+    using KeyIndex = std::pair<KeyType, size_t>;
+
+public:
+    RecordSort(Iterator begin, Iterator end, KeyFunction key_function, KeyComparator comparator, SortAlgorithm algorithm = SortAlgorithm::Default) noexcept
+    {
+        std::vector<KeyIndex> keys;
+        keys.reserve(std::distance(begin, end));
+        size_t index = 0;
+        for (Iterator record = begin; record != end; std::advance(record, 1), ++index)
+        {
+            keys.emplace_back(key_function(*record), index);
+        }
+
+        Sort(keys.begin(), keys.end(), KeyIndexComparator{ comparator }, algorithm);
+        ApplyPermutation(begin, keys);
+    }
+
+private:
+    struct KeyIndexComparator
+    {
+        KeyComparator Comparator;
+
+        bool operator()(const KeyIndex& first, const KeyIndex& second) const noexcept
+        {
+            if (Comparator(first.first, second.first)) { return true; }
+            if (Comparator(second.first, first.first)) { return false; }
+            return first.second > second.second;
+        }
+    };
+
+    /*
+    * Moves the record at keys[i].second to position i for every i.
+    * Each cycle of the permutation is followed from its first position: that record is moved out, every other record of the cycle is moved once to its final place and the first one is moved to the last free place.
+    * The visited positions are marked pointing them to themselves.
+    */
+    static void ApplyPermutation(Iterator begin, std::vector<KeyIndex>& keys) noexcept
+    {
+        for (size_t start = 0; start < keys.size(); ++start)
+        {
+            if (keys[start].second == start) { continue; }
+
+            IteratorType record = std::move(*std::next(begin, start));
+            size_t current = start;
+            while (keys[current].second != start)
+            {
+                const size_t next = keys[current].second;
+                *std::next(begin, current) = std::move(*std::next(begin, next));
+                keys[current].second = current;
+                current = next;
+            }
+            *std::next(begin, current) = std::move(record);
+            keys[current].second = current;
+        }
+    }
+};
@@ -0,0 +1,425 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* Multi-process shared memory sort header.
+*
+* SharedMemorySort sorts a container with several worker processes instead of threads. It is a sample sort in a single shared memory segment:
+* 1. The coordinator creates a memfd segment with room for two copies of the data and forks the workers, which inherit the mapping.
+*    Every worker is pinned to the CPUs of one NUMA node, round robin, and copies its slice of the container to the segment itself, so the pages of the slice are placed on its node.
+* 2. Every worker sorts its slice with Default Sort and publishes evenly spaced samples of it.
+* 3. Every worker sorts all the samples and picks the same splitters, one per worker but the last, and counts how many elements of its slice go to every bucket.
+* 4. All-to-all exchange: every worker copies every part of its slice to the region of the second copy owned by the bucket of that part.
+* 5. Every worker merges the sorted parts of its bucket with a LoserTree back to the first copy, which ends up sorted. The coordinator copies it back to the container.
+* The workers wait for each other between the steps at a process-shared pthread barrier, and report the time of every step and the time spent waiting,
+* so the report shows how every phase scales with the number of processes.
+*
+* Only Linux is supported. On other systems, or if the segment or the processes can not be created, the container is sorted by Default Sort in this process.
+* The elements are copied between processes byte by byte, so they must be trivially copyable and can not point to memory of the coordinator that changes during the sort.
+* Forking a process that runs other threads is only safe as long as those threads do not hold locks the workers need, like the one of the memory allocator.
+*
+* Time complexity: O((n / p) log n) per worker for p workers.
+* Space complexity: O(n) of shared memory.
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include <algorithm>    //For std::copy, std::fill, std::min, std::max and std::upper_bound
+#include <chrono>       //For std::chrono::steady_clock
+#include <iterator>     //For std::next, std::distance and std::iterator_traits
+#include <type_traits>  //For std::is_trivially_copyable_v
+#include <utility>      //For std::pair
+#include <vector>       //For std::vector
+
+#ifdef __linux__
+#include <pthread.h>    //For pthread_barrier_t
+#include <sched.h>      //For cpu_set_t and sched_setaffinity
+#include <signal.h>     //For kill and SIGKILL
+#include <sys/mman.h>   //For memfd_create, mmap and munmap
+#include <sys/prctl.h>  //For prctl
+#include <sys/wait.h>   //For waitpid
+#include <unistd.h>     //For fork, ftruncate, close and _exit
+#include <cstdio>       //For std::fopen and std::fscanf
+#include <filesystem>   //For std::filesystem::directory_iterator
+#include <string>       //For std::string
+#include <thread>       //For std::this_thread::sleep_for
+#endif
+
+#include "Sort.hpp"
+#include "KWayMerge.hpp"
+
+//Seconds spent in every phase. The worker phases are the ones of the slowest worker.
+struct SharedSortReport
+{
+    size_t Workers = 0;         //Worker processes used. 0 if the container was sorted in this process.
+    double Setup = 0.0;         //Creating the segment and starting the workers.
+    double LocalSort = 0.0;     //Copying the slice to the segment and sorting it.
+    double Splitters = 0.0;     //Sampling, choosing the splitters and counting the buckets.
+    double Exchange = 0.0;      //Copying the buckets to their workers.
+    double Merge = 0.0;         //Merging the parts of every bucket.
+    double Wait = 0.0;          //Waiting for the other workers at the barriers.
+    double Collect = 0.0;       //Copying the result back to the container.
+    double Total = 0.0;
+};
+
+class SharedMemorySort
+{
+public:
+    /*
+    * Sorts the container with the given number of worker processes, fewer if the slices would be too small.
+    * Returns false if the container had to be sorted in this process because the workers could not be used.
+    */
+    template<typename Iterator, typename Comparator>
+    static bool Sort(Iterator begin, Iterator end, Comparator comparator, size_t workers, SharedSortReport* report = nullptr) noexcept
+    {
+        using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+        static_assert(std::is_trivially_copyable_v<IteratorType>, "SharedMemorySort copies the elements between processes, so they must be trivially copyable");
+
+        const auto start = std::chrono::steady_clock::now();
+        SharedSortReport local_report;
+        SharedSortReport& result = report != nullptr ? *report : local_report;
+        result = SharedSortReport();
+
+        const size_t size = std::distance(begin, end);
+        workers = std::min(workers, size / s_MinWorkerSize);
+#ifdef __linux__
+        if (workers > 1 && _SortImp(begin, size, comparator, workers, result))
+        {
+            result.Total = _SecondsSince(start);
+            return true;
+        }
+#endif
+        ::Sort<Iterator, Comparator>(begin, end, comparator);
+        result = SharedSortReport();
+        result.Total = _SecondsSince(start);
+        return workers <= 1;
+    }
+
+private:
+    static double _SecondsSince(std::chrono::steady_clock::time_point start) noexcept
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+#ifdef __linux__
+    enum WorkerPhase : size_t
+    {
+        LocalSortPhase,
+        SplittersPhase,
+        ExchangePhase,
+        MergePhase,
+        WaitPhase,
+        PhaseCount
+    };
+
+    //Pointers to the parts of the shared segment. Every part starts at a cache line.
+    template<typename T>
+    struct SharedLayout
+    {
+        pthread_barrier_t* Barrier;
+        double* Timings;        //[worker][phase]
+        size_t* Counts;         //[worker][bucket]: elements of the slice of the worker that go to the bucket.
+        T* Samples;             //[worker][sample]
+        T* Data;                //Slices, sorted slices and finally the sorted container.
+        T* Exchange;            //Parts of the slices ordered by bucket.
+        size_t Workers;
+        size_t Size;
+        size_t SampleSize;      //Samples per worker.
+        void* Segment;
+        size_t SegmentSize;
+    };
+
+    template<typename Iterator, typename Comparator>
+    static bool _SortImp(Iterator begin, size_t size, Comparator comparator, size_t workers, SharedSortReport& report) noexcept
+    {
+        using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+        const auto setup_start = std::chrono::steady_clock::now();
+
+        SharedLayout<IteratorType> layout;
+        layout.Workers = workers;
+        layout.Size = size;
+        layout.SampleSize = std::min(s_Oversampling * workers, size / workers);
+        if (!_CreateSegment(layout)) { return false; }
+
+        pthread_barrierattr_t attributes;
+        pthread_barrierattr_init(&attributes);
+        pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        const bool barrier = pthread_barrier_init(layout.Barrier, &attributes, static_cast<unsigned>(workers)) == 0;
+        pthread_barrierattr_destroy(&attributes);
+        if (!barrier)
+        {
+            munmap(layout.Segment, layout.SegmentSize);
+            return false;
+        }
+
+        const std::vector<cpu_set_t> nodes = _ReadNodes();
+        std::vector<pid_t> processes;
+        processes.reserve(workers);
+        for (size_t worker = 0; worker < workers; ++worker)
+        {
+            const pid_t process = fork();
+            if (process == 0)
+            {
+                //The worker dies with the coordinator, so it never waits forever at a barrier nobody else will reach.
+                prctl(PR_SET_PDEATHSIG, SIGKILL);
+                if (!nodes.empty()) { sched_setaffinity(0, sizeof(cpu_set_t), &nodes[worker % nodes.size()]); }
+                _Worker(layout, worker, begin, comparator);
+                _exit(0);
+            }
+            if (process < 0) { break; }
+            processes.push_back(process);
+        }
+        report.Setup = _SecondsSince(setup_start);
+
+        const bool finished = processes.size() == workers && _WaitWorkers(processes);
+        const auto collect_start = std::chrono::steady_clock::now();
+        if (finished)
+        {
+            std::copy(layout.Data, layout.Data + size, begin);
+            report.Workers = workers;
+            report.LocalSort = _SlowestPhase(layout, LocalSortPhase);
+            report.Splitters = _SlowestPhase(layout, SplittersPhase);
+            report.Exchange = _SlowestPhase(layout, ExchangePhase);
+            report.Merge = _SlowestPhase(layout, MergePhase);
+            report.Wait = _SlowestPhase(layout, WaitPhase);
+        }
+        else
+        {
+            _KillWorkers(processes);
+        }
+        report.Collect = _SecondsSince(collect_start);
+
+        pthread_barrier_destroy(layout.Barrier);
+        munmap(layout.Segment, layout.SegmentSize);
+        return finished;
+    }
+
+    //Runs in the worker processes.
+    template<typename Iterator, typename Comparator>
+    static void _Worker(const SharedLayout<typename std::iterator_traits<Iterator>::value_type>& layout, size_t worker, Iterator begin, Comparator comparator) noexcept
+    {
+        using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+        const size_t workers = layout.Workers;
+        double* timings = layout.Timings + worker * PhaseCount;
+        const auto barrier = [&]()
+        {
+            const auto start = std::chrono::steady_clock::now();
+            pthread_barrier_wait(layout.Barrier);
+            timings[WaitPhase] += _SecondsSince(start);
+        };
+
+        //Local sort of the slice, copied by this worker so its pages are placed on the node of the worker.
+        auto start = std::chrono::steady_clock::now();
+        IteratorType* slice_begin = layout.Data + _SliceBegin(layout, worker);
+        IteratorType* slice_end = layout.Data + _SliceBegin(layout, worker + 1);
+        std::copy(std::next(begin, _SliceBegin(layout, worker)), std::next(begin, _SliceBegin(layout, worker + 1)), slice_begin);
+        ::Sort<IteratorType*, Comparator>(slice_begin, slice_end, comparator);
+        const size_t slice_size = std::distance(slice_begin, slice_end);
+        for (size_t sample = 0; sample < layout.SampleSize; ++sample)
+        {
+            layout.Samples[worker * layout.SampleSize + sample] = slice_begin[(2 * sample + 1) * slice_size / (2 * layout.SampleSize)];
+        }
+        timings[LocalSortPhase] = _SecondsSince(start);
+        barrier();
+
+        //Every worker sorts its own copy of the samples, so all of them pick the same splitters without waiting for each other.
+        //Bucket b gets the elements after splitter b - 1 and up to splitter b.
+        start = std::chrono::steady_clock::now();
+        std::vector<IteratorType> samples(layout.Samples, layout.Samples + workers * layout.SampleSize);
+        ::Sort<typename std::vector<IteratorType>::iterator, Comparator>(samples.begin(), samples.end(), comparator);
+        std::vector<IteratorType*> bounds(workers + 1);
+        bounds[0] = slice_begin;
+        bounds[workers] = slice_end;
+        for (size_t bucket = 0; bucket + 1 < workers; ++bucket)
+        {
+            const IteratorType& splitter = samples[(bucket + 1) * layout.SampleSize];
+            bounds[bucket + 1] = std::upper_bound(bounds[bucket], slice_end, splitter, [&](const IteratorType& value, const IteratorType& element) { return comparator(element, value); });
+        }
+        for (size_t bucket = 0; bucket < workers; ++bucket)
+        {
+            layout.Counts[worker * workers + bucket] = std::distance(bounds[bucket], bounds[bucket + 1]);
+        }
+        timings[SplittersPhase] = _SecondsSince(start);
+        barrier();
+
+        //Every bucket starts after the previous buckets, and inside a bucket the part of every worker starts after the parts of the previous workers.
+        start = std::chrono::steady_clock::now();
+        size_t bucket_begin = 0;
+        size_t own_begin = 0;
+        for (size_t bucket = 0; bucket < workers; ++bucket)
+        {
+            size_t part_begin = bucket_begin;
+            for (size_t other = 0; other < workers; ++other)
+            {
+                if (other == worker) { std::copy(bounds[bucket], bounds[bucket + 1], layout.Exchange + part_begin); }
+                part_begin += layout.Counts[other * workers + bucket];
+            }
+            if (bucket == worker) { own_begin = bucket_begin; }
+            bucket_begin = part_begin;
+        }
+        timings[ExchangePhase] = _SecondsSince(start);
+        barrier();
+
+        start = std::chrono::steady_clock::now();
+        std::vector<std::pair<const IteratorType*, const IteratorType*>> parts;
+        parts.reserve(workers);
+        const IteratorType* part = layout.Exchange + own_begin;
+        for (size_t other = 0; other < workers; ++other)
+        {
+            const size_t part_size = layout.Counts[other * workers + worker];
+            if (part_size != 0) { parts.push_back({ part, part + part_size }); }
+            part += part_size;
+        }
+        KWayMerge::Merge(parts, layout.Data + own_begin, comparator);
+        timings[MergePhase] = _SecondsSince(start);
+    }
+
+    template<typename T>
+    static size_t _SliceBegin(const SharedLayout<T>& layout, size_t worker) noexcept
+    {
+        return worker * layout.Size / layout.Workers;
+    }
+
+    template<typename T>
+    static double _SlowestPhase(const SharedLayout<T>& layout, WorkerPhase phase) noexcept
+    {
+        double slowest = 0.0;
+        for (size_t worker = 0; worker < layout.Workers; ++worker)
+        {
+            slowest = std::max(slowest, layout.Timings[worker * PhaseCount + phase]);
+        }
+        return slowest;
+    }
+
+    template<typename T>
+    static bool _CreateSegment(SharedLayout<T>& layout) noexcept
+    {
+        const auto align = [](size_t offset) { return (offset + s_CacheLineSize - 1) / s_CacheLineSize * s_CacheLineSize; };
+        const size_t timings_offset = align(sizeof(pthread_barrier_t));
+        const size_t counts_offset = align(timings_offset + layout.Workers * PhaseCount * sizeof(double));
+        const size_t samples_offset = align(counts_offset + layout.Workers * layout.Workers * sizeof(size_t));
+        const size_t data_offset = align(samples_offset + layout.Workers * layout.SampleSize * sizeof(T));
+        const size_t exchange_offset = align(data_offset + layout.Size * sizeof(T));
+        layout.SegmentSize = exchange_offset + layout.Size * sizeof(T);
+
+        //The mapping is shared with the workers through fork. The file descriptor is not needed once the segment is mapped.
+        const int file = memfd_create("SharedMemorySort", MFD_CLOEXEC);
+        if (file < 0) { return false; }
+        void* segment = MAP_FAILED;
+        if (ftruncate(file, static_cast<off_t>(layout.SegmentSize)) == 0)
+        {
+            segment = mmap(nullptr, layout.SegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        }
+        close(file);
+        if (segment == MAP_FAILED) { return false; }
+
+        char* base = static_cast<char*>(segment);
+        layout.Segment = segment;
+        layout.Barrier = reinterpret_cast<pthread_barrier_t*>(base);
+        layout.Timings = reinterpret_cast<double*>(base + timings_offset);
+        layout.Counts = reinterpret_cast<size_t*>(base + counts_offset);
+        layout.Samples = reinterpret_cast<T*>(base + samples_offset);
+        layout.Data = reinterpret_cast<T*>(base + data_offset);
+        layout.Exchange = reinterpret_cast<T*>(base + exchange_offset);
+        std::fill(layout.Timings, layout.Timings + layout.Workers * PhaseCount, 0.0);
+        return true;
+    }
+
+    //CPUs of every NUMA node, from /sys/devices/system/node/node*/cpulist. Empty if the system does not report its nodes.
+    static std::vector<cpu_set_t> _ReadNodes() noexcept
+    {
+        std::vector<cpu_set_t> nodes;
+        std::error_code error;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error))
+        {
+            const std::string name = entry.path().filename().string();
+            if (name.size() < 5 || name.compare(0, 4, "node") != 0 || name.find_first_not_of("0123456789", 4) != std::string::npos) { continue; }
+
+            //The list looks like 0-3,8-11.
+            FILE* file = std::fopen((entry.path() / "cpulist").string().c_str(), "r");
+            if (file == nullptr) { continue; }
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            unsigned first = 0;
+            while (std::fscanf(file, "%u", &first) == 1)
+            {
+                unsigned last = first;
+                const int separator = std::fgetc(file);
+                if (separator == '-' && std::fscanf(file, "%u", &last) == 1) { std::fgetc(file); }
+                for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) { CPU_SET(cpu, &cpus); }
+            }
+            std::fclose(file);
+            if (CPU_COUNT(&cpus) != 0) { nodes.push_back(cpus); }
+        }
+        return nodes;
+    }
+
+    /*
+    * Waits for every worker and returns true if all of them finished normally.
+    * The workers are polled instead of waited one after another: if one of them dies, the others wait forever at the barrier and have to be killed.
+    */
+    static bool _WaitWorkers(std::vector<pid_t>& processes) noexcept
+    {
+        size_t running = processes.size();
+        while (running != 0)
+        {
+            for (pid_t& process : processes)
+            {
+                if (process <= 0) { continue; }
+                int status = 0;
+                const pid_t waited = waitpid(process, &status, WNOHANG);
+                if (waited == 0) { continue; }
+                process = 0;
+                --running;
+                if (waited < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) { return false; }
+            }
+            if (running != 0) { std::this_thread::sleep_for(std::chrono::microseconds(s_PollInterval)); }
+        }
+        return true;
+    }
+
+    static void _KillWorkers(const std::vector<pid_t>& processes) noexcept
+    {
+        for (const pid_t process : processes)
+        {
+            if (process > 0) { kill(process, SIGKILL); }
+        }
+        for (const pid_t process : processes)
+        {
+            if (process > 0) { waitpid(process, nullptr, 0); }
+        }
+    }
+#endif
+
+private:
+    static constexpr size_t s_MinWorkerSize = size_t(1) << 14;  //Smaller slices are not worth a process.
+    static constexpr size_t s_Oversampling = 32;                //Samples per worker for every bucket.
+    static constexpr size_t s_CacheLineSize = 64;
+    static constexpr size_t s_PollInterval = 200;               //Microseconds between checks of the workers.
+};
@@ -14,6 +14,8 @@
 * Insertion sort
 * Merge sort
 * Quick sort
+* Learned sort
+* Merge insertion sort
 */
 
 /*
@@ -41,8 +43,17 @@ Copyright (c) 2021 Luis Poveda Cano
 */
 
 #include <iterator>     //For std::advance, std::prev, std::distance
-#include <algorithm>    //For std::iter_swap
+#include <algorithm>    //For std::iter_swap, std::min, std::max, std::clamp, std::copy, std::move_backward, std::reverse, std::find, std::upper_bound, std::lower_bound, std::partition_point and std::minmax_element
 #include <vector>       //For std::vector
+#include <array>        //For std::array
+#include <utility>      //For std::pair
+#include <functional>   //For std::greater and std::less
+#include <type_traits>  //For std::is_integral_v, std::is_arithmetic_v, std::is_same_v, std::is_base_of_v and std::make_unsigned_t
+#include <thread>       //For std::thread
+#include <atomic>       //For std::atomic
+
+#include "SortProfile.hpp"
+#include "SortThreadPool.hpp"
 
 enum class SortAlgorithm : unsigned char
 {
@@ -51,21 +62,72 @@ enum class SortAlgorithm : unsigned char
     SelectionSort,
     InsertionSort,
     MergeSort,
-    QuickSort
+    QuickSort,
+    LearnedSort,
+    MergeInsertionSort
+};
+
+/*
+* Scratch memory used by the sorts.
+* The vectors are only cleared between uses, so their capacity only grows and a scratch reused by several sorts stops allocating once it is big enough.
+* The elements are move constructed into the unused capacity of Buffer and destroyed when it is cleared, so T does not need to be default constructible or copyable.
+*/
+template<typename T>
+struct SortScratch
+{
+    std::vector<T> Buffer;          //Elements moved out of the container while merging.
+    std::vector<size_t> Runs;       //Offsets of the runs to merge.
+    std::vector<size_t> Counts;     //Counting sort counters.
+    std::vector<size_t> Segments;   //Segments of a segmented sort ordered by size.
+    std::vector<size_t> Buckets;    //Learned Sort: first position of every bucket, followed by the next position to write in every bucket.
+    std::vector<T> Lanes;           //Learned Sort: a cache line of elements of every bucket waiting to be written.
+    std::vector<unsigned char> LaneFill;    //Learned Sort: elements waiting in every lane.
+    std::vector<double> Model;      //Learned Sort: sorted sample and model.
 };
 
 template<typename Iterator, typename Comparator>
 class Sort
 {
     using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+
+    //Sorts the container one partition at a time with the partitions of Quick Sort and Default Sort.
+    template<typename, typename> friend class LazySortedView;
+    //Reduces the groups of equal elements left by the three-way partition of Default Sort.
+    friend class SortReduce;
+    //Learned Sort sorts its sample of doubles with the three-way QuickSort, which does not allocate memory.
+    template<typename, typename> friend class Sort;
 public:
+    //Uses the configuration stored in the global SortProfile for the element size.
     Sort(Iterator begin, Iterator end, Comparator comparator, SortAlgorithm algorithm = SortAlgorithm::Default) noexcept :
+        Sort(begin, end, comparator, algorithm, SortProfile::FindGlobal<sizeof(IteratorType)>())
+    {
+    }
+
+    /*
+    * The scratch memory and the thread pool are optional. Without scratch, the sort allocates the memory it needs and frees it at the end.
+    * Without thread pool, the parallel Default Sort creates its own threads.
+    */
+    Sort(Iterator begin, Iterator end, Comparator comparator, SortAlgorithm algorithm, const SortConfiguration& configuration,
+        SortScratch<IteratorType>* scratch = nullptr, SortThreadPool* pool = nullptr) noexcept :
         m_Begin(begin),
-        m_End(end)
+        m_End(end),
+        m_Comparator(comparator),
+        m_Configuration(configuration),
+        m_Scratch(scratch != nullptr ? scratch : &m_LocalScratch),
+        m_Pool(pool)
     {
         Run(comparator, algorithm);
     }
 
+    /*
+    * Merge Sort, Quick Sort and Default Sort do not use recursion, so they are safe to run on small stacks like the ones of fibers or coroutines.
+    * The pending partitions are kept in a fixed capacity stack and the larger partition is always the one pushed while the smaller one is sorted.
+    * Every pushed partition is at most half the size of the previous one, so the stack never holds more than log2(n) partitions.
+    * MaxStackFootprint is the size in bytes of that stack, the only part of the stack usage that depends on the number of elements.
+    */
+    static constexpr size_t MaxStackDepth = sizeof(size_t) * 8;
+    static constexpr size_t MaxStackFootprint = MaxStackDepth * 2 * sizeof(Iterator);
+
     //Sort implementations
 private:
     /*
@@ -165,10 +227,11 @@ private:
 
     /*
     * Merge sort is a divide and conquer algorithm.
-    * For each pass, the vector is divided by the middle into left vector and right vector.
-    * This recursive process keeps until the partitions size is 1.
-    * Once the divide process has finished, starts to merge those partitions and sort them in the process.
-    * In this implementation, for merge the partitions, std::vectors are created.
+    * In this implementation the container is divided bottom-up, so no recursion is needed.
+    * First, blocks of SortConfiguration::MergeTile elements (1 by default) are sorted by InsertionSort.
+    * Then, for each pass, adjacent partitions are merged and sorted in the process, doubling the partitions size until there is only one.
+    * In this implementation, for merge the partitions, the elements already in place at both ends are skipped and only the smaller of the remaining parts is moved to the scratch buffer.
+    * Elements are only moved, never copied, so move-only types like std::unique_ptr can be sorted.
     * Stable sort
     *
     * Time complexity:
@@ -179,14 +242,27 @@ private:
     */
     void MergeSort(Iterator begin, Iterator end, Comparator comparator) noexcept
     {
-        std::advance(end, -1);
-        _MergeSortImp(begin, end, comparator);
+        const size_t size = std::distance(begin, end);
+        const size_t tile = std::max<size_t>(m_Configuration.MergeTile, 1);
+        for (size_t left = 0; left < size; left += tile)
+        {
+            InsertionSort(std::next(begin, left), std::next(begin, std::min(left + tile, size)), comparator);
+        }
+
+        for (size_t width = tile; width < size; width *= 2)
+        {
+            for (size_t left = 0; left + width < size; left += 2 * width)
+            {
+                const size_t right = std::min(left + 2 * width, size);
+                _MergeAdjacent(std::next(begin, left), std::next(begin, left + width), std::next(begin, right), comparator, m_Scratch->Buffer);
+            }
+        }
     }
 
     /*
     * Quick sort is a divide and conquer algorithm.
     * For each pass, the vector is divided in two parts, the left part is lesser than the pivot value and the right part is greater than the pivot value.
-    * In this implementation, the pivot value is the median of 3 values.
+    * In this implementation, the pivot value is chosen by SortConfiguration::PivotSample, by default the median of 3 values.
     * These are the element at 1/4, the element at 1/2 and the element at 3/4 of the container.
     * This recursive process keeps until the container is sorted.
     * Not stable sort
@@ -199,200 +275,981 @@ private:
     */
     void QuickSort(Iterator begin, Iterator end, Comparator comparator) noexcept
     {
-        _QuickSortImp(begin, end, comparator);
+        _QuickSortImp(begin, std::prev(end), comparator);
     }
 
     /*
     * Default Sort is an optimized version of QuickSort.
-    * If the number of elements to sort is less than 200, then perform an InsertionSort.
+    * If the number of elements to sort is less than SortConfiguration::LeafCutoff (200 by default), then perform an InsertionSort.
+    * Otherwise, a linear pre-pass measures the run structure of the input and a sample measures its inversions and duplicates:
+    * Sorted input returns at once and reversed input is reversed in place. Input with few runs, ascending or descending, is sorted reversing the descending runs and merging them all.
+    * Integers compared with std::greater or std::less whose key range is not bigger than the number of elements are sorted by counting.
+    * Input with many duplicates is sorted by a QuickSort with three-way partitioning and input whose sample has no inversions is first tried with a bounded InsertionSort.
     * Otherwise, perform an optimized QuickSort.
     * This optimized QuickSort consists in splitting the container but once the container has a certain size, sort it by InsertionSort instead of splitting it further.
+    * Partitions whose pivot is equal to the pivot that bounded them are split with three-way partitioning, so groups of duplicates missed by the sample are not split one element at a time.
+    * If SortConfiguration::ParallelGrain is not 0, partitions of at least that size are sorted by another thread while there are free hardware threads.
     *
     * Time complexity:
-    * Best: O(n log n)
+    * Best: O(n)
     * Worst: O(n^2)
     * Average: O(n log n)
-    * Space complexity: O(1)
+    * Space complexity: O(1), O(n) when merging runs or counting.
     */
     void DefaultSort(Iterator begin, Iterator end, Comparator comparator) noexcept
     {
         const size_t size = std::distance(begin, end);
-        if (size <= 200)
+        if (size <= m_Configuration.LeafCutoff)
         {
             InsertionSort(begin, end, comparator);
+            return;
         }
-        else
+
+        const size_t max_runs = std::max<size_t>(size / s_MaxRunsDivisor, 1);
+        bool descending = false;
+        const size_t runs = _CountRuns(begin, end, comparator, max_runs, descending);
+        if (runs == 1)
+        {
+            if (descending) { std::reverse(begin, end); }
+            return;
+        }
+        if (runs <= max_runs)
+        {
+            _MergeRuns(begin, end, comparator);
+            return;
+        }
+        if (_CountingSort(begin, end, size)) { return; }
+
+        const size_t sample_size = std::min(size, s_SampleSize);
+        size_t inversions = 0;
+        size_t duplicates = 0;
+        _AnalyzeSample(begin, size, sample_size, comparator, inversions, duplicates);
+        if (duplicates * 2 >= sample_size)
+        {
+            _ThreeWaySortImp(begin, std::prev(end), comparator);
+            return;
+        }
+        if (inversions == 0 && _PartialInsertionSort(begin, end, comparator, size)) { return; }
+
+        _DefaultSortImp(begin, std::prev(end), comparator);
+        if (m_Pool != nullptr) { m_Pool->Wait(m_TaskGroup); }
+    }
+
+    /*
+    * Learned Sort is a bucket sort whose buckets come from a model of the distribution of the values, for integers and floating point values compared with std::greater or std::less.
+    * The model is a piecewise linear approximation of the cumulative distribution function: a sorted sample gives the fraction of values below the edges of equally wide cells
+    * and the values inside a cell are interpolated linearly. The model maps every value to one of up to s_LearnedMaxBuckets buckets in value order.
+    * After counting the elements of every bucket, the elements are scattered to their buckets in a single pass through small per bucket buffers the size of a cache line,
+    * so every write to memory is a whole line instead of a single element. Finally, every bucket is sorted by a second, linear, bucket pass and InsertionSort.
+    * If the sample is duplicate heavy or the model puts too many elements in a single bucket, as it happens with skewed data, Default Sort is used instead.
+    * Other types, comparators or containers without random access are sorted by Default Sort.
+    * Not stable sort
+    *
+    * Time complexity:
+    * Best: O(n)
+    * Worst: O(n^2), the one of Default Sort.
+    * Average: O(n) for smooth distributions.
+    * Space complexity: O(n)
+    */
+    void LearnedSort(Iterator begin, Iterator end, Comparator comparator) noexcept
+    {
+        if constexpr (std::is_arithmetic_v<IteratorType> && !std::is_same_v<IteratorType, bool> && (s_Ascending || s_Descending) && s_RandomAccess)
         {
-            _DefaultSortImp(begin, end, comparator);
+            const size_t size = std::distance(begin, end);
+            if (size >= s_LearnedMinSize && _LearnedSortImp(begin, end, comparator, size)) { return; }
         }
+        DefaultSort(begin, end, comparator);
+    }
+
+    /*
+    * Merge Insertion Sort minimizes the number of calls to the comparator, for comparators that cost much more than moving elements.
+    * The container is split in blocks of up to s_MergeInsertionMax elements of the same size, which are sorted by merge insertion (Ford-Johnson):
+    * the elements are compared in pairs, the larger elements are sorted recursively and the smaller ones are inserted by binary search in the order that keeps every search
+    * within a power of two minus one elements. Then the blocks are merged in pairs, so the merges are balanced, switching to galloping when one side keeps winning.
+    * Results already known are never asked again: the smaller element of a pair is searched only before its larger one, and a gallop that stops at an element
+    * already knows which side takes the next element. No pair of elements is ever compared twice.
+    * The sort moves indices of the elements, and the elements themselves are moved once at the end, following the cycles of the permutation.
+    * Uses about n log2(n) - 1.3n comparisons on random input, close to the lower bound log2(n!).
+    * Not stable sort
+    *
+    * Time complexity:
+    * Best: O(n log n)
+    * Worst: O(n log n) comparisons, O(n log n) moves of indices.
+    * Average: O(n log n)
+    * Space complexity: O(n)
+    */
+    void MergeInsertionSort(Iterator begin, Iterator end, Comparator comparator) noexcept
+    {
+        //Elements are reached by their index. Without random access, an iterator to every element is kept.
+        const size_t size = std::distance(begin, end);
+        std::vector<Iterator> elements;
+        if constexpr (!s_RandomAccess)
+        {
+            elements.reserve(size);
+            for (Iterator element = begin; element != end; std::advance(element, 1)) { elements.push_back(element); }
+        }
+        const auto element = [&](size_t index) -> typename std::iterator_traits<Iterator>::reference
+        {
+            if constexpr (s_RandomAccess) { return begin[index]; }
+            else { return *elements[index]; }
+        };
+        const auto less = [&](size_t first, size_t second) { return comparator(element(second), element(first)); };
+
+        //order[k] is the index of the element that goes at position k.
+        std::vector<size_t>& order = m_Scratch->Counts;
+        std::vector<size_t>& buffer = m_Scratch->Runs;
+        order.resize(size);
+        buffer.resize(size);
+        for (size_t i = 0; i < size; ++i) { order[i] = i; }
+
+        size_t blocks = 1;
+        while (size > blocks * s_MergeInsertionMax) { blocks *= 2; }
+        MergeInsertionPartners partners;
+        for (size_t block = 0; block < blocks; ++block)
+        {
+            const size_t block_begin = block * size / blocks;
+            _MergeInsertion(order.data() + block_begin, (block + 1) * size / blocks - block_begin, block_begin, 0, less, partners);
+        }
+
+        //The sorted blocks are merged from order to buffer and back until there is only one.
+        for (size_t width = 1; width < blocks; width *= 2)
+        {
+            for (size_t block = 0; block < blocks; block += 2 * width)
+            {
+                const size_t first = block * size / blocks;
+                const size_t middle = (block + width) * size / blocks;
+                const size_t last = (block + 2 * width) * size / blocks;
+                _GallopingMerge(order.data() + first, order.data() + middle, order.data() + last, buffer.data() + first, less);
+            }
+            order.swap(buffer);
+        }
+
+        _ApplyPermutation(element, order);
+        order.clear();
+        buffer.clear();
     }
 
     //Internal functions
 private:
     //Merge Sort internal.
-    void _MergeSortImp(Iterator left, Iterator right, Comparator comparator) noexcept
+
+    //Merges the sorted ranges [begin, middle) and [middle, end) keeping the stability. Also used by Default Sort to merge runs.
+    static void _MergeAdjacent(Iterator begin, Iterator middle, Iterator end, Comparator comparator, std::vector<IteratorType>& buffer) noexcept
     {
-        const size_t left_distance = std::distance(m_Begin, left);
-        const size_t right_distance = std::distance(m_Begin, right);
+        if (begin == middle || middle == end) { return; }
+        if (!comparator(*std::prev(middle), *middle)) { return; }
 
-        if (left_distance >= right_distance) { return; }
+        //The left elements not greater than the first right element and the right elements not less than the last left element are already placed.
+        begin = std::upper_bound(begin, middle, *middle, [&](const IteratorType& value, const IteratorType& element) { return comparator(element, value); });
+        end = std::lower_bound(middle, end, *std::prev(middle), [&](const IteratorType& element, const IteratorType& value) { return comparator(value, element); });
 
-        const size_t middle_distance = (left_distance + right_distance - 1) / 2;
-        Iterator middle = m_Begin;
-        std::advance(middle, middle_distance);
-        _MergeSortImp(left, middle, comparator);
-        _MergeSortImp(std::next(middle), right, comparator);
-        _MergeSubData(left, middle, right, comparator);
+        buffer.clear();
+        if (std::distance(begin, middle) <= std::distance(middle, end))
+        {
+            for (Iterator aux = begin; aux != middle; std::advance(aux, 1)) { buffer.push_back(std::move(*aux)); }
+
+            auto left = buffer.begin();
+            Iterator right = middle;
+            Iterator output = begin;
+            while (left != buffer.end() && right != end)
+            {
+                if (comparator(*left, *right)) { *output = std::move(*right); std::advance(right, 1); }
+                else { *output = std::move(*left); std::advance(left, 1); }
+                std::advance(output, 1);
+            }
+            std::move(left, buffer.end(), output);
+        }
+        else
+        {
+            for (Iterator aux = middle; aux != end; std::advance(aux, 1)) { buffer.push_back(std::move(*aux)); }
+
+            auto right = buffer.end();
+            Iterator left = middle;
+            Iterator output = end;
+            while (right != buffer.begin() && left != begin)
+            {
+                std::advance(output, -1);
+                if (comparator(*std::prev(left), *std::prev(right))) { std::advance(left, -1); *output = std::move(*left); }
+                else { std::advance(right, -1); *output = std::move(*right); }
+            }
+            std::move_backward(buffer.begin(), right, output);
+        }
     }
 
-    void _MergeSubData(Iterator left, Iterator middle, Iterator right, Comparator comparator) noexcept
+    //Fixed capacity stack of the partitions pending to sort, used instead of recursion.
+    class PartitionStack
     {
-        const size_t vector_left_size = std::distance(left, middle) + 1;
-        const size_t vector_right_size = std::distance(middle, right);
+    public:
+        void Push(Iterator left, Iterator right) noexcept
+        {
+            m_Partitions[m_Size++] = { left, right };
+        }
 
-        std::vector<typename Iterator::value_type> left_vector;
-        std::vector<typename Iterator::value_type> right_vector;
-        left_vector.reserve(vector_left_size);
-        right_vector.reserve(vector_right_size);
+        bool Pop(Iterator& left, Iterator& right) noexcept
+        {
+            if (m_Size == 0) { return false; }
+            --m_Size;
+            left = m_Partitions[m_Size].first;
+            right = m_Partitions[m_Size].second;
+            return true;
+        }
 
-        Iterator aux = left;
-        for (size_t i = 0; i < vector_left_size; ++i, std::advance(aux, 1))
+    private:
+        std::array<std::pair<Iterator, Iterator>, MaxStackDepth> m_Partitions;
+        size_t m_Size = 0;
+    };
+
+    /*
+    * Pushes the larger of the partitions [left, lower) and [upper, right] and leaves the smaller one in left and right.
+    * Partitions with less than 2 elements are never pushed. Returns false if the smaller one has less than 2 elements.
+    */
+    static bool _PushLarger(PartitionStack& stack, Iterator& left, Iterator lower, Iterator upper, Iterator& right) noexcept
+    {
+        const size_t left_size = std::distance(left, lower);
+        const size_t right_size = std::distance(upper, std::next(right));
+        if (left_size < right_size)
         {
-            left_vector.push_back(*aux);
+            if (right_size > 1) { stack.Push(upper, right); }
+            if (left_size < 2) { return false; }
+            right = std::prev(lower);
         }
-        aux = middle;
-        std::advance(aux, 1);
-        for (size_t i = 0; i < vector_right_size; ++i, std::advance(aux, 1))
+        else
         {
-            right_vector.push_back(*aux);
+            if (left_size > 1) { stack.Push(left, std::prev(lower)); }
+            if (right_size < 2) { return false; }
+            left = upper;
         }
+        return true;
+    }
 
-        Iterator left_vector_iterator = left_vector.begin();
-        Iterator right_vector_iterator = right_vector.begin();
-        aux = left;
-        while (left_vector_iterator != left_vector.end() && right_vector_iterator != right_vector.end())
+    //Quick Sort internal.
+    void _QuickSortImp(Iterator left, Iterator right, Comparator comparator) noexcept
+    {
+        PartitionStack stack;
+        stack.Push(left, right);
+        while (stack.Pop(left, right))
         {
-            if (comparator(*right_vector_iterator, *left_vector_iterator))
+            while (true)
             {
-                *aux = *left_vector_iterator;
-                std::advance(left_vector_iterator, 1);
+                const Iterator pivot_iterator = _QuickSortPartition(left, right, _SelectPivot(left, right, comparator), comparator);
+                if (!_PushLarger(stack, left, pivot_iterator, std::next(pivot_iterator), right)) { break; }
             }
-            else
+        }
+    }
+
+    //Partitions [left, right] around the pivot, chosen by _SelectPivot. Returns where the pivot ends.
+    Iterator _QuickSortPartition(Iterator left, Iterator right, Iterator pivot, Comparator comparator) noexcept
+    {
+        Iterator pivot_value = pivot;
+        Iterator pivot_index = left;
+
+        for (; left != pivot_value; std::advance(left, 1))
+        {
+            if (comparator(*pivot_value, *left))
             {
-                *aux = *right_vector_iterator;
-                std::advance(right_vector_iterator, 1);
+                std::iter_swap(left, pivot_index);
+                std::advance(pivot_index, 1);
             }
-            std::advance(aux, 1);
         }
+        std::iter_swap(pivot_index, pivot_value);
+        pivot_value = pivot_index;
+        pivot_index = right;
+        for (; right != pivot_value; std::advance(right, -1))
+        {
+            if (comparator(*right, *pivot_value))
+            {
+                std::iter_swap(right, pivot_index);
+                std::advance(pivot_index, -1);
+            }
+        }
+        std::iter_swap(pivot_index, pivot_value);
+
+        return pivot_index;
+    }
 
-        while (left_vector_iterator != left_vector.end())
+    //Chooses the pivot sampling SortConfiguration::PivotSample elements of the partition.
+    Iterator _SelectPivot(Iterator left, Iterator right, Comparator comparator) const noexcept
+    {
+        const size_t half = std::distance(left, right) / 2;
+        const Iterator middle = std::next(left, half);
+        if (m_Configuration.PivotSample < 3) { return middle; }
+
+        const size_t quarter = half / 2;
+        if (m_Configuration.PivotSample < 9 || quarter < 4)
         {
-            *aux = *left_vector_iterator;
-            std::advance(left_vector_iterator, 1);
-            std::advance(aux, 1);
+            return _MedianOf3(std::next(left, quarter), middle, std::prev(right, quarter), comparator);
         }
-        while (right_vector_iterator != right_vector.end())
+
+        //Median of the medians of 3 of the beginning, the middle and the end of the partition.
+        const size_t eighth = quarter / 2;
+        const Iterator first = _MedianOf3(left, std::next(left, eighth), std::next(left, quarter), comparator);
+        const Iterator second = _MedianOf3(std::prev(middle, eighth), middle, std::next(middle, eighth), comparator);
+        const Iterator third = _MedianOf3(std::prev(right, quarter), std::prev(right, eighth), right, comparator);
+        return _MedianOf3(first, second, third, comparator);
+    }
+
+    static Iterator _MedianOf3(Iterator first, Iterator second, Iterator third, Comparator comparator) noexcept
+    {
+        if (comparator(*first, *second))
         {
-            *aux = *right_vector_iterator;
-            std::advance(right_vector_iterator, 1);
-            std::advance(aux, 1);
+            if (comparator(*third, *second))
+            {
+                return comparator(*first, *third) ? third : first;
+            }
         }
+        else
+        {
+            if (comparator(*second, *third))
+            {
+                return comparator(*third, *first) ? third : first;
+            }
+        }
+        return second;
     }
 
-    //Quick Sort internal.
-    void _QuickSortImp(Iterator left, Iterator right, Comparator comparator) noexcept
+    //Default Sort internal.
+
+    /*
+    * Returns the end of the run that starts at begin, which must not be end. A run is the longest range that is either not descending or not ascending,
+    * and its first pair of different elements tells which one. descending is set for runs that are not ascending, which are reversed before merging them.
+    * Equal elements are allowed in both kinds of runs, so reversed input with duplicates is a single run too. Default Sort is not stable, so reversing them is fine.
+    */
+    static Iterator _FindRunEnd(Iterator begin, Iterator end, Comparator comparator, bool& descending) noexcept
     {
-        const size_t left_distance = std::distance(m_Begin, left);
-        const size_t right_distance = std::distance(m_Begin, right);
-        if (left_distance >= right_distance) { return; }
+        Iterator current = begin;
+        Iterator next = std::next(begin);
+        while (next != end && !comparator(*current, *next) && !comparator(*next, *current))
+        {
+            current = next;
+            std::advance(next, 1);
+        }
 
-        const Iterator pivot_iterator = _QuickSortPartition(left, right, comparator);
-        if (pivot_iterator != m_Begin) { _QuickSortImp(left, std::prev(pivot_iterator), comparator); }
-        if (pivot_iterator != std::prev(m_End)) { _QuickSortImp(std::next(pivot_iterator), right, comparator); }
+        descending = next != end && comparator(*current, *next);
+        for (; next != end; current = next, std::advance(next, 1))
+        {
+            if (descending ? comparator(*next, *current) : comparator(*current, *next)) { break; }
+        }
+        return next;
     }
 
-    Iterator _QuickSortPartition(Iterator left, Iterator right, Comparator comparator) noexcept
+    /*
+    * Counts the runs of the container, as _FindRunEnd finds them. The scan stops once there are more than max_runs runs, returning max_runs + 1.
+    * Returns 1 for sorted and reversed containers. descending tells which one it is.
+    */
+    static size_t _CountRuns(Iterator begin, Iterator end, Comparator comparator, size_t max_runs, bool& descending) noexcept
     {
-        Iterator pivot_value = m_Begin;
-        Iterator pivot_index = left;
-        const size_t half = std::distance(left, right) / 2;
-        std::advance(pivot_value,half);
-        const size_t quarter = half / 2;
-        Iterator left_quarter = std::next(left, quarter);
-        Iterator right_quarter = std::prev(right, quarter);
+        size_t runs = 0;
+        while (begin != end)
+        {
+            if (++runs > max_runs) { return max_runs + 1; }
+            begin = _FindRunEnd(begin, end, comparator, descending);
+        }
+        return runs;
+    }
+
+    /*
+    * Sorts by reversing the descending runs and merging adjacent runs until only one is left.
+    * Elements already in their final place at both ends of each pair of runs are skipped and only the smaller part is moved to the buffer.
+    */
+    void _MergeRuns(Iterator begin, Iterator end, Comparator comparator) noexcept
+    {
+        std::vector<size_t>& runs = m_Scratch->Runs;
+        runs.clear();
+        size_t offset = 0;
+        for (Iterator current = begin; current != end;)
+        {
+            runs.push_back(offset);
+            bool descending = false;
+            const Iterator run_end = _FindRunEnd(current, end, comparator, descending);
+            if (descending) { std::reverse(current, run_end); }
+            offset += std::distance(current, run_end);
+            current = run_end;
+        }
+        runs.push_back(offset);
 
-        if (comparator(*left_quarter, *pivot_value))
+        while (runs.size() > 2)
         {
-            if (comparator(*right_quarter, *pivot_value))
+            size_t count = 0;
+            size_t i = 0;
+            for (; i + 2 < runs.size(); i += 2)
             {
-                if (comparator(*left_quarter, *right_quarter))
-                {
-                    pivot_value = right_quarter;
-                }
-                else
+                _MergeAdjacent(std::next(begin, runs[i]), std::next(begin, runs[i + 1]), std::next(begin, runs[i + 2]), comparator, m_Scratch->Buffer);
+                runs[count++] = runs[i];
+            }
+            for (; i < runs.size(); ++i)
+            {
+                runs[count++] = runs[i];
+            }
+            runs.resize(count);
+        }
+    }
+
+    //Counting sort for integers compared with std::greater or std::less. Returns false if the key range is bigger than the number of elements.
+    bool _CountingSort(Iterator begin, Iterator end, size_t size) noexcept
+    {
+        if constexpr (std::is_integral_v<IteratorType> && !std::is_same_v<IteratorType, bool> && (s_Ascending || s_Descending))
+        {
+            using UnsignedType = std::make_unsigned_t<IteratorType>;
+            const auto [min, max] = std::minmax_element(begin, end);
+            const UnsignedType min_value = static_cast<UnsignedType>(*min);
+            const UnsignedType range = static_cast<UnsignedType>(static_cast<UnsignedType>(*max) - min_value);
+            if (range >= size) { return false; }
+
+            std::vector<size_t>& counts = m_Scratch->Counts;
+            counts.assign(static_cast<size_t>(range) + 1, 0);
+            for (Iterator aux = begin; aux != end; std::advance(aux, 1))
+            {
+                ++counts[static_cast<UnsignedType>(static_cast<UnsignedType>(*aux) - min_value)];
+            }
+
+            Iterator output = begin;
+            for (size_t i = 0; i < counts.size(); ++i)
+            {
+                const size_t key = s_Ascending ? i : counts.size() - 1 - i;
+                const IteratorType value = static_cast<IteratorType>(static_cast<UnsignedType>(min_value + key));
+                output = std::fill_n(output, counts[key], value);
+            }
+            return true;
+        }
+        else
+        {
+            (void)begin; (void)end; (void)size;
+            return false;
+        }
+    }
+
+    //Sorts sample_size evenly spaced positions by their values and counts the inversions found and the equal adjacent values.
+    static void _AnalyzeSample(Iterator begin, size_t size, size_t sample_size, Comparator comparator, size_t& inversions, size_t& duplicates) noexcept
+    {
+        std::array<Iterator, s_SampleSize> sample;
+        const size_t step = size / sample_size;
+        for (size_t i = 0; i < sample_size; ++i)
+        {
+            sample[i] = std::next(begin, i * step);
+        }
+
+        for (size_t i = 1; i < sample_size; ++i)
+        {
+            const Iterator pivot = sample[i];
+            size_t j = i;
+            for (; j > 0 && comparator(*sample[j - 1], *pivot); --j)
+            {
+                sample[j] = sample[j - 1];
+                ++inversions;
+            }
+            sample[j] = pivot;
+        }
+
+        for (size_t i = 1; i < sample_size; ++i)
+        {
+            if (!comparator(*sample[i], *sample[i - 1])) { ++duplicates; }
+        }
+    }
+
+    //InsertionSort that gives up once it has moved more than limit elements. Returns true if the container was sorted.
+    static bool _PartialInsertionSort(Iterator begin, Iterator end, Comparator comparator, size_t limit) noexcept
+    {
+        size_t moves = 0;
+        Iterator pivot = begin;
+        for (std::advance(pivot, 1); pivot != end; std::advance(pivot, 1))
+        {
+            Iterator prev = std::prev(pivot);
+            if (!comparator(*prev, *pivot)) { continue; }
+
+            Iterator current = pivot;
+            IteratorType pivot_value = std::move(*pivot);
+            do
+            {
+                *current = std::move(*prev);
+                std::advance(current, -1);
+                ++moves;
+                if (current == begin) { break; }
+                std::advance(prev, -1);
+            } while (comparator(*prev, pivot_value));
+            *current = std::move(pivot_value);
+
+            if (moves > limit) { return false; }
+        }
+        return true;
+    }
+
+    //QuickSort with three-way partitioning. The elements equal to the pivot are left in the middle and never sorted again.
+    void _ThreeWaySortImp(Iterator left, Iterator right, Comparator comparator) noexcept
+    {
+        PartitionStack stack;
+        stack.Push(left, right);
+        while (stack.Pop(left, right))
+        {
+            while (true)
+            {
+                const size_t size = std::distance(left, right) + 1;
+                if (size <= m_Configuration.LeafCutoff)
                 {
-                    pivot_value = left_quarter;
+                    InsertionSort(left, std::next(right), comparator);
+                    break;
                 }
+
+                const auto [lower, upper] = _ThreeWayPartition(left, right, _SelectPivot(left, right, comparator), comparator);
+                if (!_PushLarger(stack, left, lower, upper, right)) { break; }
             }
         }
-        else
+    }
+
+    //Partitions [left, right] around the pivot, chosen by _SelectPivot. Returns the first element equal to the pivot and the first element greater than it.
+    std::pair<Iterator, Iterator> _ThreeWayPartition(Iterator left, Iterator right, Iterator pivot, Comparator comparator) const noexcept
+    {
+        //The element at lower is always equal to the pivot. [left, lower) is lesser, [lower, current) is equal and [upper, right] is greater.
+        std::iter_swap(left, pivot);
+        Iterator lower = left;
+        Iterator current = std::next(left);
+        Iterator upper = std::next(right);
+        while (current != upper)
+        {
+            if (comparator(*lower, *current))
+            {
+                std::iter_swap(lower, current);
+                std::advance(lower, 1);
+                std::advance(current, 1);
+            }
+            else if (comparator(*current, *lower))
+            {
+                std::advance(upper, -1);
+                std::iter_swap(current, upper);
+            }
+            else
+            {
+                std::advance(current, 1);
+            }
+        }
+
+        return { lower, upper };
+    }
+
+    void _DefaultSortImp(Iterator left, Iterator right, Comparator comparator) noexcept
+    {
+        std::vector<std::thread> threads;
+        PartitionStack stack;
+        stack.Push(left, right);
+        while (stack.Pop(left, right))
         {
-            if (comparator(*pivot_value, *right_quarter))
+            while (true)
             {
-                if (comparator(*right_quarter, *left_quarter))
+                if (static_cast<size_t>(std::distance(left, right)) < m_Configuration.LeafCutoff)
                 {
-                    pivot_value = right_quarter;
+                    InsertionSort(left, std::next(right), comparator);
+                    break;
                 }
-                else
+
+                //The element after a partition is the pivot that bounded it, not lesser than any of its elements.
+                //If the new pivot is equal to it, the partition is full of duplicates, which the two-way partition would split one at a time.
+                const Iterator pivot = _SelectPivot(left, right, comparator);
+                if (std::next(right) != m_End && !comparator(*std::next(right), *pivot))
+                {
+                    const auto [lower, upper] = _ThreeWayPartition(left, right, pivot, comparator);
+                    if (!_PushLarger(stack, left, lower, upper, right)) { break; }
+                    continue;
+                }
+
+                const Iterator pivot_iterator = _QuickSortPartition(left, right, pivot, comparator);
+                const Iterator upper = std::next(pivot_iterator);
+                if (_AcquireThread(std::distance(left, pivot_iterator), std::distance(upper, std::next(right))))
                 {
-                    pivot_value = left_quarter;
+                    if (m_Pool != nullptr)
+                    {
+                        m_Pool->Submit(m_TaskGroup, &Sort::_DefaultSortTask, this, std::distance(m_Begin, upper), std::distance(m_Begin, right));
+                    }
+                    else
+                    {
+                        threads.emplace_back([this, upper, right, comparator]()
+                        {
+                            _DefaultSortImp(upper, right, comparator);
+                            m_ThreadCount.fetch_sub(1);
+                        });
+                    }
+                    right = std::prev(pivot_iterator);
+                    continue;
                 }
+                if (!_PushLarger(stack, left, pivot_iterator, upper, right)) { break; }
             }
         }
 
-        for (; left != pivot_value; std::advance(left, 1))
+        for (std::thread& thread : threads)
         {
-            if (comparator(*pivot_value, *left))
+            thread.join();
+        }
+    }
+
+    //Sorts a partition submitted to the thread pool. The partition limits are offsets from the beginning of the container.
+    static void _DefaultSortTask(void* context, size_t left, size_t right) noexcept
+    {
+        Sort* sort = static_cast<Sort*>(context);
+        sort->_DefaultSortImp(std::next(sort->m_Begin, left), std::next(sort->m_Begin, right), sort->m_Comparator);
+    }
+
+    //Reserves a thread if both partitions are big enough to be sorted in parallel.
+    bool _AcquireThread(size_t left_size, size_t right_size) noexcept
+    {
+        if (m_Configuration.ParallelGrain == 0) { return false; }
+        if (left_size < m_Configuration.ParallelGrain || right_size < m_Configuration.ParallelGrain) { return false; }
+        if (m_Pool != nullptr) { return m_Pool->GetThreadCount() != 0; }
+
+        const size_t max_threads = std::thread::hardware_concurrency();
+        size_t count = m_ThreadCount.load();
+        while (count + 1 < max_threads)
+        {
+            if (m_ThreadCount.compare_exchange_weak(count, count + 1)) { return true; }
+        }
+        return false;
+    }
+
+    //Learned Sort internal.
+
+    //Piecewise linear model of the cumulative distribution function scaled to the number of buckets.
+    struct LearnedModel
+    {
+        double Min = 0.0;
+        double Scale = 0.0;                 //Cells per unit of value.
+        const double* Base = nullptr;       //Bucket position of the lower edge of every cell. Base and Slope live in the scratch memory.
+        const double* Slope = nullptr;      //Buckets from the lower to the upper edge of every cell.
+        size_t Buckets = 0;
+
+        size_t Bucket(IteratorType value) const noexcept
+        {
+            const double position = (static_cast<double>(value) - Min) * Scale;
+            size_t bucket = 0;
+            if (position >= static_cast<double>(s_LearnedCells)) { bucket = Buckets - 1; }
+            else if (position > 0.0)
             {
-                std::iter_swap(left, pivot_index);
-                std::advance(pivot_index, 1);
+                const size_t cell = static_cast<size_t>(position);
+                bucket = std::min(static_cast<size_t>(Base[cell] + Slope[cell] * (position - static_cast<double>(cell))), Buckets - 1);
             }
+            return s_Ascending ? bucket : Buckets - 1 - bucket;
         }
-        std::iter_swap(pivot_index, pivot_value);
-        pivot_value = pivot_index;
-        pivot_index = right;
-        for (; right != pivot_value; std::advance(right, -1))
+    };
+
+    //Sorts by the model. Returns false, without moving any element, if the model does not fit the data.
+    bool _LearnedSortImp(Iterator begin, Iterator end, Comparator comparator, size_t size) noexcept
+    {
+        LearnedModel model;
+        if (!_FitLearnedModel(begin, size, model)) { return false; }
+
+        //offsets[bucket] is the first position of the bucket and next[bucket] the next position to write in it.
+        std::vector<size_t>& positions = m_Scratch->Buckets;
+        positions.assign(2 * model.Buckets + 1, 0);
+        size_t* const offsets = positions.data();
+        size_t* const next = offsets + model.Buckets + 1;
+        for (Iterator element = begin; element != end; std::advance(element, 1))
         {
-            if (comparator(*right, *pivot_value))
+            ++offsets[model.Bucket(*element) + 1];
+        }
+        const size_t max_bucket_size = s_LearnedMaxBucketFactor * (size / model.Buckets);
+        for (size_t bucket = 1; bucket <= model.Buckets; ++bucket)
+        {
+            if (offsets[bucket] > max_bucket_size) { return false; }
+            offsets[bucket] += offsets[bucket - 1];
+        }
+
+        //The elements are scattered back from a copy. Every bucket buffers a cache line of elements and writes them together once it is full.
+        std::vector<IteratorType>& copy = m_Scratch->Buffer;
+        copy.clear();
+        copy.insert(copy.end(), begin, end);
+        constexpr size_t lane_size = std::max<size_t>(s_CacheLineSize / sizeof(IteratorType), 1);
+        std::vector<IteratorType>& lanes = m_Scratch->Lanes;
+        std::vector<unsigned char>& lane_fill = m_Scratch->LaneFill;
+        lanes.resize(model.Buckets * lane_size);
+        lane_fill.assign(model.Buckets, 0);
+        std::copy(offsets, offsets + model.Buckets, next);
+        for (const IteratorType value : copy)
+        {
+            const size_t bucket = model.Bucket(value);
+            IteratorType* lane = &lanes[bucket * lane_size];
+            lane[lane_fill[bucket]++] = value;
+            if (lane_fill[bucket] == lane_size)
             {
-                std::iter_swap(right, pivot_index);
-                std::advance(pivot_index, -1);
+                std::copy(lane, lane + lane_size, std::next(begin, next[bucket]));
+                next[bucket] += lane_size;
+                lane_fill[bucket] = 0;
             }
         }
-        std::iter_swap(pivot_index, pivot_value);
+        for (size_t bucket = 0; bucket < model.Buckets; ++bucket)
+        {
+            std::copy(&lanes[bucket * lane_size], &lanes[bucket * lane_size] + lane_fill[bucket], std::next(begin, next[bucket]));
+        }
 
-        return pivot_index;
+        //With discrete keys the model leaves many buckets empty.
+        for (size_t bucket = 0; bucket < model.Buckets; ++bucket)
+        {
+            const size_t bucket_size = offsets[bucket + 1] - offsets[bucket];
+            if (bucket_size < 2) { continue; }
+            _LearnedFixup(std::next(begin, offsets[bucket]), std::next(begin, offsets[bucket + 1]), bucket_size, comparator);
+        }
+        return true;
     }
 
-    //Default Sort internal.
-    void _DefaultSortImp(Iterator left, Iterator right, Comparator comparator) noexcept
+    /*
+    * Sorts a bucket. Inside a bucket the distribution is close to uniform, so the elements are first counting sorted into small sub buckets
+    * by linear interpolation between the minimum and the maximum of the bucket, which leaves every element near its place, and then InsertionSort finishes the job.
+    * The bucket fits in cache, so these passes are cheap. If InsertionSort has to move too many elements, the bucket is sorted by Default Sort.
+    */
+    void _LearnedFixup(Iterator left, Iterator right, size_t size, Comparator comparator) noexcept
     {
-        const size_t left_distance = std::distance(m_Begin, left);
-        const size_t right_distance = std::distance(m_Begin, right);
-        if (left_distance >= right_distance) { return; }
-        if (right_distance - left_distance <= 200)
+        if (size < 2) { return; }
+        if (size <= m_Configuration.LeafCutoff)
+        {
+            InsertionSort(left, right, comparator);
+            return;
+        }
+
+        const auto [min, max] = std::minmax_element(left, right);
+        if (!comparator(*min, *max) && !comparator(*max, *min)) { return; }
+
+        //Distinct integers above 2^53 can be the same double, and then the interpolation can not tell them apart.
+        const double min_value = static_cast<double>(*min);
+        const double max_value = static_cast<double>(*max);
+        if (!(min_value < max_value))
         {
-            InsertionSort(left, std::next(right), comparator);
+            DefaultSort(left, right, comparator);
             return;
         }
 
-        const Iterator pivot_iterator = _QuickSortPartition(left, right, comparator);
-        if (pivot_iterator != m_Begin) { _DefaultSortImp(left, std::prev(pivot_iterator), comparator); }
-        if (pivot_iterator != std::prev(m_End)) { _DefaultSortImp(std::next(pivot_iterator), right, comparator); }
+        const size_t sub_buckets = std::max<size_t>(size / s_LearnedSubBucketSize, 2);
+        const double scale = static_cast<double>(sub_buckets - 1) / (max_value - min_value);
+        const auto sub_bucket = [&](IteratorType value)
+        {
+            const size_t index = std::min(static_cast<size_t>((static_cast<double>(value) - min_value) * scale), sub_buckets - 1);
+            return s_Ascending ? index : sub_buckets - 1 - index;
+        };
+
+        std::vector<size_t>& counts = m_Scratch->Counts;
+        counts.assign(sub_buckets + 1, 0);
+        for (Iterator element = left; element != right; std::advance(element, 1))
+        {
+            ++counts[sub_bucket(*element) + 1];
+        }
+        for (size_t i = 1; i <= sub_buckets; ++i)
+        {
+            counts[i] += counts[i - 1];
+        }
+        std::vector<IteratorType>& buffer = m_Scratch->Buffer;
+        buffer.resize(size);
+        for (Iterator element = left; element != right; std::advance(element, 1))
+        {
+            buffer[counts[sub_bucket(*element)]++] = *element;
+        }
+        std::copy(buffer.begin(), buffer.end(), left);
+
+        if (!_PartialInsertionSort(left, right, comparator, s_LearnedMaxMoves * size)) { DefaultSort(left, right, comparator); }
+    }
+
+    //Fits the model on a sorted sample of s_LearnedSampleSize elements. Returns false if the sample has no spread or is mostly duplicates.
+    bool _FitLearnedModel(Iterator begin, size_t size, LearnedModel& model) const noexcept
+    {
+        //The scratch memory holds the sample followed by the base and the slope of every cell.
+        std::vector<double>& memory = m_Scratch->Model;
+        memory.resize(s_LearnedSampleSize + 2 * s_LearnedCells);
+        double* const sample = memory.data();
+        double* const base = sample + s_LearnedSampleSize;
+        double* const slope = base + s_LearnedCells;
+
+        //One element of every stratum of the container, at a pseudo random position inside it so patterns in the input do not bias the sample.
+        const size_t step = size / s_LearnedSampleSize;
+        for (size_t i = 0; i < s_LearnedSampleSize; ++i)
+        {
+            const size_t jitter = (i * 2654435761u) % step;
+            sample[i] = static_cast<double>(*std::next(begin, i * step + jitter));
+        }
+        //Sort of an empty range that lends its three-way QuickSort, which handles duplicate heavy samples and never allocates memory, unlike the run merging of Default Sort.
+        Sort<double*, std::greater<double>> sample_sort(sample, sample, std::greater<double>(), SortAlgorithm::Default, m_Configuration);
+        sample_sort._ThreeWaySortImp(sample, sample + s_LearnedSampleSize - 1, std::greater<double>());
+
+        size_t duplicates = 0;
+        for (size_t i = 1; i < s_LearnedSampleSize; ++i)
+        {
+            if (sample[i] == sample[i - 1]) { ++duplicates; }
+        }
+        if (duplicates * 2 >= s_LearnedSampleSize || !(sample[0] < sample[s_LearnedSampleSize - 1])) { return false; }
+
+        model.Min = sample[0];
+        model.Scale = static_cast<double>(s_LearnedCells) / (sample[s_LearnedSampleSize - 1] - sample[0]);
+        model.Buckets = std::clamp<size_t>(size / s_LearnedBucketSize, 2, s_LearnedMaxBuckets);
+        model.Base = base;
+        model.Slope = slope;
+
+        //Fraction of the sample below the lower edge of every cell, scaled to the buckets.
+        size_t below = 0;
+        const double bucket_scale = static_cast<double>(model.Buckets) / static_cast<double>(s_LearnedSampleSize);
+        for (size_t cell = 0; cell < s_LearnedCells; ++cell)
+        {
+            const double edge = model.Min + static_cast<double>(cell) / model.Scale;
+            while (below < s_LearnedSampleSize && sample[below] < edge) { ++below; }
+            base[cell] = static_cast<double>(below) * bucket_scale;
+        }
+        for (size_t cell = 0; cell + 1 < s_LearnedCells; ++cell)
+        {
+            slope[cell] = base[cell + 1] - base[cell];
+        }
+        slope[s_LearnedCells - 1] = static_cast<double>(model.Buckets) - base[s_LearnedCells - 1];
+        return true;
+    }
+
+    //Merge Insertion Sort internal.
+
+    //Declared before the rest of the constants because they size MergeInsertionPartners.
+    static constexpr size_t s_MergeInsertionMax = 64;       //Largest block sorted by merge insertion. Its insertions move O(n^2) indices.
+    static constexpr size_t s_MergeInsertionLevels = 7;     //Recursion levels of a block of s_MergeInsertionMax elements.
+
+    //Smaller elements of the pairs of every recursion level of merge insertion, by the index of their larger element.
+    using MergeInsertionPartners = std::array<std::array<size_t, s_MergeInsertionMax>, s_MergeInsertionLevels>;
+
+    //Sorts the count indices of items by merge insertion. The indices are in [base, base + count) on the first level and in a subset of it on the next ones.
+    template<typename Less>
+    static void _MergeInsertion(size_t* items, size_t count, size_t base, size_t level, const Less& less, MergeInsertionPartners& partners) noexcept
+    {
+        if (count < 2) { return; }
+
+        const size_t pairs = count / 2;
+        std::array<size_t, s_MergeInsertionMax> larger;
+        for (size_t i = 0; i < pairs; ++i)
+        {
+            size_t first = items[2 * i];
+            size_t second = items[2 * i + 1];
+            if (less(first, second)) { std::swap(first, second); }
+            larger[i] = first;
+            partners[level][first - base] = second;
+        }
+        _MergeInsertion(larger.data(), pairs, base, level + 1, less, partners);
+
+        //The main chain starts with the smaller element of the smallest pair, which is known to go first, and the sorted larger elements.
+        const size_t odd = items[count - 1];
+        items[0] = partners[level][larger[0] - base];
+        std::copy(larger.data(), larger.data() + pairs, items + 1);
+        size_t chain_size = pairs + 1;
+
+        //The smaller elements are inserted in groups that end at the Jacobsthal numbers 3, 5, 11, 21..., each group from its last element to its first one,
+        //so every element is searched in at most 2^k - 1 elements with k comparisons. The search of an element stops before its larger element.
+        const size_t pending = count - pairs;
+        size_t group_begin = 1;
+        size_t group_end = 3;
+        while (group_begin < pending)
+        {
+            for (size_t j = std::min(group_end, pending); j > group_begin; --j)
+            {
+                const bool paired = j <= pairs;
+                const size_t item = paired ? partners[level][larger[j - 1] - base] : odd;
+                const size_t bound = paired ? std::find(items, items + chain_size, larger[j - 1]) - items : chain_size;
+                size_t* position = std::upper_bound(items, items + bound, item, less);
+                std::move_backward(position, items + chain_size, items + chain_size + 1);
+                *position = item;
+                ++chain_size;
+            }
+            const size_t next_end = group_end + 2 * group_begin;
+            group_begin = group_end;
+            group_end = next_end;
+        }
+    }
+
+    /*
+    * Merges the indices [first, middle) and [middle, last) to output, taking the first run on ties.
+    * After s_MinGallop wins in a row of the same run, the runs are merged by galloping: the number of elements the run takes is found by exponential search.
+    */
+    template<typename Less>
+    static void _GallopingMerge(const size_t* first, const size_t* middle, const size_t* last, size_t* output, const Less& less) noexcept
+    {
+        const size_t* left = first;
+        const size_t* right = middle;
+        if (left == middle || right == last || !less(*right, *std::prev(middle)))
+        {
+            std::copy(right, last, std::copy(left, middle, output));
+            return;
+        }
+
+        size_t left_wins = 0;
+        size_t right_wins = 0;
+        while (left != middle && right != last)
+        {
+            if (less(*right, *left))
+            {
+                *output++ = *right++;
+                ++right_wins;
+                left_wins = 0;
+            }
+            else
+            {
+                *output++ = *left++;
+                ++left_wins;
+                right_wins = 0;
+            }
+            if (left_wins < s_MinGallop && right_wins < s_MinGallop) { continue; }
+
+            while (left != middle && right != last)
+            {
+                //Elements of the left run that are not greater than the right element. The one the search stopped at is greater, so the right element goes next.
+                const size_t* left_stop = _Gallop(left, middle, [&](size_t element) { return !less(*right, element); });
+                const size_t left_taken = left_stop - left;
+                output = std::copy(left, left_stop, output);
+                left = left_stop;
+                if (left == middle) { break; }
+                *output++ = *right++;
+                if (right == last) { break; }
+
+                //Elements of the right run lesser than the left element. The one the search stopped at is not, so the left element goes next.
+                const size_t* right_stop = _Gallop(right, last, [&](size_t element) { return less(element, *left); });
+                const size_t right_taken = right_stop - right;
+                output = std::copy(right, right_stop, output);
+                right = right_stop;
+                if (right == last) { break; }
+                *output++ = *left++;
+
+                if (left_taken < s_MinGallop && right_taken < s_MinGallop) { break; }
+            }
+            left_wins = 0;
+            right_wins = 0;
+        }
+        std::copy(right, last, std::copy(left, middle, output));
+    }
+
+    //First element of [begin, end) that is not taken, for a predicate true for a prefix of the range. Probes 1, 3, 7... elements and then searches the last gap.
+    template<typename Predicate>
+    static const size_t* _Gallop(const size_t* begin, const size_t* end, const Predicate& taken) noexcept
+    {
+        const size_t size = end - begin;
+        size_t low = 0;
+        size_t high = 1;
+        while (high <= size && taken(begin[high - 1]))
+        {
+            low = high;
+            high = 2 * high + 1;
+        }
+        high = std::min(high - 1, size);
+        return std::partition_point(begin + low, begin + high, taken);
+    }
+
+    //Moves the elements to their positions in order, each element once, following the cycles of the permutation. Leaves order as the identity.
+    template<typename Element>
+    static void _ApplyPermutation(const Element& element, std::vector<size_t>& order) noexcept
+    {
+        for (size_t start = 0; start < order.size(); ++start)
+        {
+            if (order[start] == start) { continue; }
+
+            IteratorType value = std::move(element(start));
+            size_t position = start;
+            while (true)
+            {
+                const size_t next = order[position];
+                order[position] = position;
+                if (next == start) { break; }
+                element(position) = std::move(element(next));
+                position = next;
+            }
+            element(position) = std::move(value);
+        }
     }
 
     inline void Run(Comparator comparator, SortAlgorithm algorithm) noexcept
     {
+        if (std::distance(m_Begin, m_End) < 2) { return; }
+
         switch (algorithm)
         {
         case SortAlgorithm::Default:
@@ -413,10 +1270,44 @@ private:
         case SortAlgorithm::QuickSort:
             QuickSort(m_Begin, m_End, comparator);
             break;
+        case SortAlgorithm::LearnedSort:
+            LearnedSort(m_Begin, m_End, comparator);
+            break;
+        case SortAlgorithm::MergeInsertionSort:
+            MergeInsertionSort(m_Begin, m_End, comparator);
+            break;
         }
     }
 
 private:
     Iterator m_Begin;
     Iterator m_End;
+    Comparator m_Comparator;
+    SortConfiguration m_Configuration;
+    SortScratch<IteratorType> m_LocalScratch;
+    SortScratch<IteratorType>* m_Scratch;
+    SortThreadPool* m_Pool;
+    SortThreadPool::TaskGroup m_TaskGroup;
+    std::atomic<size_t> m_ThreadCount{ 0 };
+
+    //Default Sort input analysis.
+    static constexpr size_t s_SampleSize = 64;
+    static constexpr size_t s_MaxRunsDivisor = 32;  //Input with size / s_MaxRunsDivisor runs or less is sorted merging the runs.
+    static constexpr bool s_Ascending = std::is_same_v<Comparator, std::greater<IteratorType>> || std::is_same_v<Comparator, std::greater<>>;
+    static constexpr bool s_Descending = std::is_same_v<Comparator, std::less<IteratorType>> || std::is_same_v<Comparator, std::less<>>;
+    static constexpr bool s_RandomAccess = std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>;
+
+    //Learned Sort model.
+    static constexpr size_t s_LearnedMinSize = size_t(1) << 14;     //Smaller containers are sorted by Default Sort.
+    static constexpr size_t s_LearnedSampleSize = size_t(1) << 12;
+    static constexpr size_t s_LearnedCells = size_t(1) << 10;       //Linear pieces of the model.
+    static constexpr size_t s_LearnedBucketSize = 256;              //Expected elements per bucket, while there are not more than s_LearnedMaxBuckets.
+    static constexpr size_t s_LearnedMaxBuckets = size_t(1) << 12;
+    static constexpr size_t s_LearnedMaxBucketFactor = 16;          //A bucket with this many times the expected elements means the model does not fit.
+    static constexpr size_t s_LearnedSubBucketSize = 4;             //Expected elements per sub bucket when sorting a bucket.
+    static constexpr size_t s_LearnedMaxMoves = 8;                  //Moves per element allowed to the InsertionSort that finishes a bucket.
+    static constexpr size_t s_CacheLineSize = 64;
+
+    //Merge Insertion Sort.
+    static constexpr size_t s_MinGallop = 7;                //Wins in a row of the same run that start galloping.
 };
@@ -0,0 +1,233 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* Sort configuration and per-machine profile header.
+*
+* SortConfiguration holds the thresholds used by the sort engines.
+* SortProfile stores one SortConfiguration per element size and can be saved to and loaded from a text file.
+* The global profile is loaded on first use from the file pointed by the SORT_PROFILE environment variable, if any.
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include <atomic>       //For std::atomic
+#include <cerrno>       //For errno and ERANGE
+#include <cstddef>      //For size_t
+#include <cstdint>      //For SIZE_MAX
+#include <cstdlib>      //For std::getenv and std::strtoull
+#include <fstream>      //For std::ifstream and std::ofstream
+#include <sstream>      //For std::istringstream
+#include <string>       //For std::string
+#include <map>          //For std::map
+#include <mutex>        //For std::mutex and std::lock_guard
+
+/*
+* Thresholds used by the sort engines.
+* It is a literal type, so it can be declared constexpr and passed to Sort as a compile time configuration.
+*/
+struct SortConfiguration
+{
+    size_t LeafCutoff = 200;    //Partitions with this number of elements or less are sorted by InsertionSort in Default Sort.
+    size_t PivotSample = 3;     //Number of elements sampled to choose the pivot: 1 (middle element), 3 (median of 3) or 9 (median of medians of 3).
+    size_t ParallelGrain = 0;   //Minimum partition size that Default Sort hands to another thread. 0 disables the parallel sort.
+    size_t MergeTile = 1;       //Blocks with this number of elements or less are sorted by InsertionSort before Merge Sort starts merging.
+
+    //The leaf and tile sizes are sorted by InsertionSort, so they are limited to keep its quadratic cost bounded.
+    static constexpr size_t s_MaxLeafCutoff = 4096;
+    static constexpr size_t s_MaxMergeTile = 4096;
+
+    constexpr bool IsValid() const noexcept
+    {
+        return LeafCutoff >= 1 && LeafCutoff <= s_MaxLeafCutoff
+            && (PivotSample == 1 || PivotSample == 3 || PivotSample == 9)
+            && MergeTile >= 1 && MergeTile <= s_MaxMergeTile;
+    }
+};
+
+class SortProfile
+{
+public:
+    //Global profile. The first call loads the file pointed by the SORT_PROFILE environment variable, if it is defined.
+    static SortProfile& Get() noexcept
+    {
+        static SortProfile s_Profile(GetEnvironmentPath());
+        return s_Profile;
+    }
+
+    /*
+    * Find on the global profile without taking its lock, for the sorts that look up their configuration on every call.
+    * Each thread keeps the configuration of each element size and only looks it up again after the profile changes.
+    */
+    template<size_t ElementSize>
+    static SortConfiguration FindGlobal() noexcept
+    {
+        static thread_local size_t s_Generation = 0;
+        static thread_local SortConfiguration s_Configuration;
+        const SortProfile& profile = Get();
+        const size_t generation = profile.m_Generation.load(std::memory_order_acquire);
+        if (s_Generation != generation)
+        {
+            s_Configuration = profile.Find(ElementSize);
+            s_Generation = generation;
+        }
+        return s_Configuration;
+    }
+
+    //Returns the configuration stored for the element size or the default configuration if there is none.
+    SortConfiguration Find(size_t element_size) const noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto iterator = m_Configurations.find(element_size);
+        if (iterator == m_Configurations.end()) { return SortConfiguration(); }
+        return iterator->second;
+    }
+
+    //Returns false and keeps the stored configuration if the new one is not valid.
+    bool Set(size_t element_size, const SortConfiguration& configuration) noexcept
+    {
+        if (!configuration.IsValid()) { return false; }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Configurations[element_size] = configuration;
+        m_Generation.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    /*
+    * The profile file has one line per element size with the following format:
+    * element_size=8 leaf_cutoff=32 pivot_sample=9 parallel_grain=65536 merge_tile=16
+    * Empty lines and lines starting with '#' are ignored. Missing keys keep their default value.
+    * The whole file is checked before anything is applied: an unknown key, a value that is not a number, a line without element_size
+    * or a configuration that is not valid makes Load return false and the profile keeps its previous configurations.
+    */
+    bool Load(const std::string& path) noexcept
+    {
+        std::ifstream file(path);
+        if (!file.is_open()) { return false; }
+
+        std::map<size_t, SortConfiguration> configurations;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.empty() || line.front() == '#') { continue; }
+
+            size_t element_size = 0;
+            SortConfiguration configuration;
+            std::istringstream stream(line);
+            std::string token;
+            while (stream >> token)
+            {
+                const size_t separator = token.find('=');
+                if (separator == std::string::npos) { return false; }
+                const std::string key = token.substr(0, separator);
+                size_t value = 0;
+                if (!ParseValue(token.c_str() + separator + 1, value)) { return false; }
+                if (key == "element_size") { element_size = value; }
+                else if (key == "leaf_cutoff") { configuration.LeafCutoff = value; }
+                else if (key == "pivot_sample") { configuration.PivotSample = value; }
+                else if (key == "parallel_grain") { configuration.ParallelGrain = value; }
+                else if (key == "merge_tile") { configuration.MergeTile = value; }
+                else { return false; }
+            }
+            if (element_size == 0 || !configuration.IsValid()) { return false; }
+            configurations[element_size] = configuration;
+        }
+        if (file.bad()) { return false; }
+
+        //Applied under a single lock and generation, so no sort sees a profile loaded halfway.
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (const auto& element : configurations)
+        {
+            m_Configurations[element.first] = element.second;
+        }
+        m_Generation.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    bool Save(const std::string& path) const noexcept
+    {
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        if (!file.is_open()) { return false; }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        file << "# Sort profile\n";
+        for (const auto& element : m_Configurations)
+        {
+            file << "element_size=" << element.first
+                << " leaf_cutoff=" << element.second.LeafCutoff
+                << " pivot_sample=" << element.second.PivotSample
+                << " parallel_grain=" << element.second.ParallelGrain
+                << " merge_tile=" << element.second.MergeTile << "\n";
+        }
+
+        return file.good();
+    }
+
+public:
+    SortProfile() noexcept { }
+
+    explicit SortProfile(const std::string& path) noexcept
+    {
+        if (!path.empty()) { Load(path); }
+    }
+
+private:
+    //Decimal digits only: std::strtoull alone would take "-1" as the largest value and ignore trailing characters.
+    static bool ParseValue(const char* text, size_t& value) noexcept
+    {
+        if (*text < '0' || *text > '9') { return false; }
+        char* end = nullptr;
+        errno = 0;
+        const unsigned long long parsed = std::strtoull(text, &end, 10);
+        if (errno == ERANGE || *end != '\0' || parsed > static_cast<unsigned long long>(SIZE_MAX)) { return false; }
+        value = static_cast<size_t>(parsed);
+        return true;
+    }
+
+    static std::string GetEnvironmentPath() noexcept
+    {
+#ifdef _MSC_VER
+        char* value = nullptr;
+        size_t length = 0;
+        std::string path;
+        if (_dupenv_s(&value, &length, "SORT_PROFILE") == 0 && value != nullptr) { path = value; }
+        free(value);
+        return path;
+#else
+        const char* value = std::getenv("SORT_PROFILE");
+        return value != nullptr ? std::string(value) : std::string();
+#endif
+    }
+
+private:
+    std::map<size_t, SortConfiguration> m_Configurations;
+    mutable std::mutex m_Mutex;
+    std::atomic<size_t> m_Generation{ 1 };    //Changes on every Set, so FindGlobal knows its cached configurations are stale.
+};
@@ -0,0 +1,244 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* Fused sort and reduce header.
+*
+* Sorting and then removing or counting the duplicates needs a second pass over the whole container.
+* SortReduce merges the equal elements while sorting instead: a QuickSort with three-way partitioning leaves every block of elements equal to a pivot in the middle,
+* and that block is reduced to a single element right away. Partitions smaller than SortConfiguration::LeafCutoff are sorted by an InsertionSort that merges
+* every element equal to one already inserted instead of inserting it.
+* The partitions are processed from left to right and every reduced element is written right after the previous one, so the result is compacted at the
+* beginning of the container as it is produced. With few distinct values almost every element is merged in its first partition pass.
+*
+* Unique keeps one element of every group of equal elements, Count also writes the size of every group and Reduce combines every group with a user combiner.
+* All of them return the new logical end of the container. The elements after it are left in a valid but unspecified state, like std::unique does.
+*
+* Time complexity: O(n log k) on average, being k the number of distinct elements.
+* Space complexity: O(1)
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include <algorithm>    //For std::iter_swap and std::move_backward
+#include <array>        //For std::array
+#include <iterator>     //For std::next, std::prev, std::distance and std::iterator_traits
+#include <utility>      //For std::move
+#include <vector>       //For std::vector
+
+#include "Sort.hpp"
+
+class SortReduce
+{
+public:
+    //Sorts the container keeping one element of every group of equal elements. Returns the new end.
+    template<typename Iterator, typename Comparator>
+    static Iterator Unique(Iterator begin, Iterator end, Comparator comparator) noexcept
+    {
+        using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+        const auto keep_first = [](IteratorType&& accumulated, IteratorType&&) { return std::move(accumulated); };
+        return Reducer<Iterator, Comparator, decltype(keep_first), size_t*, false>(begin, end, comparator, keep_first, nullptr).Run();
+    }
+
+    //Sorts the container keeping one element of every group of equal elements and writes the size of every group to counts. Returns the new end.
+    template<typename Iterator, typename CountIterator, typename Comparator>
+    static Iterator Count(Iterator begin, Iterator end, CountIterator counts, Comparator comparator) noexcept
+    {
+        using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+        const auto keep_first = [](IteratorType&& accumulated, IteratorType&&) { return std::move(accumulated); };
+        return Reducer<Iterator, Comparator, decltype(keep_first), CountIterator, true>(begin, end, comparator, keep_first, counts).Run();
+    }
+
+    /*
+    * Sorts the container replacing every group of equal elements by the combination of all of them. Returns the new end.
+    * The combiner receives the accumulated element and the next element of the group and returns their combination, like std::plus does.
+    * The elements of a group are combined in no particular order.
+    */
+    template<typename Iterator, typename Comparator, typename Combiner>
+    static Iterator Reduce(Iterator begin, Iterator end, Comparator comparator, Combiner combiner) noexcept
+    {
+        return Reducer<Iterator, Comparator, Combiner, size_t*, false>(begin, end, comparator, combiner, nullptr).Run();
+    }
+
+private:
+    template<typename Iterator, typename Comparator, typename Combiner, typename CountIterator, bool WriteCounts>
+    class Reducer
+    {
+        using IteratorType = typename std::iterator_traits<Iterator>::value_type;
+
+    public:
+        Reducer(Iterator begin, Iterator end, Comparator comparator, Combiner combiner, CountIterator counts) noexcept :
+            m_Begin(begin),
+            m_End(end),
+            m_Output(begin),
+            m_Comparator(comparator),
+            m_Combiner(combiner),
+            m_Counts(counts),
+            m_Configuration(SortProfile::FindGlobal<sizeof(IteratorType)>()),
+            m_Partitioner(end, end, comparator, SortAlgorithm::Default, m_Configuration)
+        {
+        }
+
+        Iterator Run() noexcept
+        {
+            if (m_Begin == m_End) { return m_End; }
+
+            //Blocks are processed in order, so the block on the left of a partition is pushed last. Equal blocks are reduced when popped.
+            m_Stack[m_Size++] = { m_Begin, m_End, false };
+            while (m_Size != 0)
+            {
+                const Block block = m_Stack[--m_Size];
+                Iterator left = block.Left;
+                Iterator right = block.Right;
+                if (block.Equal)
+                {
+                    _ReduceGroup(left, right);
+                    continue;
+                }
+
+                while (left != right)
+                {
+                    const size_t size = std::distance(left, right);
+                    if (size <= m_Configuration.LeafCutoff)
+                    {
+                        _ReduceLeaf(left, right);
+                        break;
+                    }
+
+                    //Partitions left when the stack is full are sorted first and reduced in a single pass.
+                    if (m_Size + 2 > m_Stack.size())
+                    {
+                        Sort(left, right, m_Comparator, SortAlgorithm::Default, m_Configuration);
+                        _ReduceSorted(left, right);
+                        break;
+                    }
+
+                    const Iterator last = std::prev(right);
+                    const auto [lower, upper] = m_Partitioner._ThreeWayPartition(left, last, m_Partitioner._SelectPivot(left, last, m_Comparator), m_Comparator);
+                    if (upper != right) { m_Stack[m_Size++] = { upper, right, false }; }
+                    m_Stack[m_Size++] = { lower, upper, true };
+                    right = lower;
+                }
+            }
+            return m_Output;
+        }
+
+    private:
+        //Writes the reduction of the group of equal elements [left, right) to the output.
+        void _ReduceGroup(Iterator left, Iterator right) noexcept
+        {
+            IteratorType accumulated = std::move(*left);
+            for (Iterator current = std::next(left); current != right; std::advance(current, 1))
+            {
+                accumulated = m_Combiner(std::move(accumulated), std::move(*current));
+            }
+            *m_Output = std::move(accumulated);
+            std::advance(m_Output, 1);
+            if constexpr (WriteCounts)
+            {
+                *m_Counts = static_cast<size_t>(std::distance(left, right));
+                ++m_Counts;
+            }
+        }
+
+        //Reduces the sorted range [left, right) in a single pass.
+        void _ReduceSorted(Iterator left, Iterator right) noexcept
+        {
+            while (left != right)
+            {
+                Iterator group_end = std::next(left);
+                while (group_end != right && !m_Comparator(*group_end, *left)) { std::advance(group_end, 1); }
+                _ReduceGroup(left, group_end);
+                left = group_end;
+            }
+        }
+
+        /*
+        * InsertionSort that builds the reduced partition directly at the output.
+        * Every element is searched from the end of the already reduced elements and combined with the one it is equal to, if any. Otherwise it is inserted.
+        * The output never goes past the element being read, because every element read adds at most one element to the output.
+        */
+        void _ReduceLeaf(Iterator left, Iterator right) noexcept
+        {
+            const Iterator first = m_Output;
+            Iterator last = m_Output;
+            if constexpr (WriteCounts) { m_LeafCounts.clear(); }
+
+            for (; left != right; std::advance(left, 1))
+            {
+                IteratorType value = std::move(*left);
+                Iterator position = last;
+                while (position != first && m_Comparator(*std::prev(position), value)) { std::advance(position, -1); }
+
+                if (position != first && !m_Comparator(value, *std::prev(position)))
+                {
+                    const Iterator equal = std::prev(position);
+                    *equal = m_Combiner(std::move(*equal), std::move(value));
+                    if constexpr (WriteCounts) { ++m_LeafCounts[std::distance(first, equal)]; }
+                    continue;
+                }
+
+                std::move_backward(position, last, std::next(last));
+                *position = std::move(value);
+                std::advance(last, 1);
+                if constexpr (WriteCounts) { m_LeafCounts.insert(m_LeafCounts.begin() + std::distance(first, position), 1); }
+            }
+
+            m_Output = last;
+            if constexpr (WriteCounts)
+            {
+                for (const size_t count : m_LeafCounts)
+                {
+                    *m_Counts = count;
+                    ++m_Counts;
+                }
+            }
+        }
+
+    private:
+        struct Block
+        {
+            Iterator Left;
+            Iterator Right;
+            bool Equal;     //Every element of the block is equal, so it only needs to be reduced.
+        };
+
+        Iterator m_Begin;
+        Iterator m_End;
+        Iterator m_Output;  //Where the next reduced element is written.
+        Comparator m_Comparator;
+        Combiner m_Combiner;
+        CountIterator m_Counts;
+        SortConfiguration m_Configuration;
+        Sort<Iterator, Comparator> m_Partitioner;   //Sort of an empty range, so it does not sort anything. It only lends its three-way partition to the reducer.
+        std::array<Block, 2 * Sort<Iterator, Comparator>::MaxStackDepth> m_Stack;
+        size_t m_Size = 0;
+        std::vector<size_t> m_LeafCounts;   //Group sizes of the reduced elements of the current leaf.
+    };
+};
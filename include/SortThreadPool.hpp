@@ -0,0 +1,160 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* Worker pool used by the parallel sorts.
+*
+* The threads are created once and reused by every sort, so a parallel sort does not create any thread.
+* The tasks are plain function pointers with two offsets and are stored in a grow-only vector, so submitting a task does not allocate once the vector has grown enough.
+* Every task belongs to a TaskGroup. The thread waiting for a group runs pending tasks while it waits instead of blocking.
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include <cstddef>              //For size_t
+#include <vector>               //For std::vector
+#include <thread>               //For std::thread
+#include <mutex>                //For std::mutex and std::unique_lock
+#include <condition_variable>   //For std::condition_variable
+
+class SortThreadPool
+{
+public:
+    using TaskFunction = void(*)(void* context, size_t left, size_t right);
+
+    //Tasks of one sort. Wait returns once all of them have finished.
+    class TaskGroup
+    {
+    private:
+        friend class SortThreadPool;
+        size_t m_Pending = 0;
+    };
+
+public:
+    void Submit(TaskGroup& group, TaskFunction function, void* context, size_t left, size_t right) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ++group.m_Pending;
+            m_Tasks.push_back({ function, context, left, right, &group });
+        }
+        m_TaskAvailable.notify_one();
+    }
+
+    //Runs pending tasks, of this group or others, until every task of the group has finished.
+    void Wait(TaskGroup& group) noexcept
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (group.m_Pending != 0)
+        {
+            if (m_Tasks.empty())
+            {
+                m_TaskFinished.wait(lock);
+                continue;
+            }
+
+            const Task task = m_Tasks.back();
+            m_Tasks.pop_back();
+            lock.unlock();
+            Execute(task);
+            lock.lock();
+        }
+    }
+
+    size_t GetThreadCount() const noexcept { return m_Threads.size(); }
+
+public:
+    explicit SortThreadPool(size_t thread_count) noexcept
+    {
+        m_Tasks.reserve(64);
+        m_Threads.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            m_Threads.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    ~SortThreadPool() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_TaskAvailable.notify_all();
+        for (std::thread& thread : m_Threads)
+        {
+            thread.join();
+        }
+    }
+
+    SortThreadPool(const SortThreadPool&) = delete;
+    SortThreadPool& operator=(const SortThreadPool&) = delete;
+
+private:
+    struct Task
+    {
+        TaskFunction Function;
+        void* Context;
+        size_t Left;
+        size_t Right;
+        TaskGroup* Group;
+    };
+
+    void Execute(const Task& task) noexcept
+    {
+        task.Function(task.Context, task.Left, task.Right);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (--task.Group->m_Pending == 0) { m_TaskFinished.notify_all(); }
+    }
+
+    void WorkerLoop() noexcept
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (true)
+        {
+            m_TaskAvailable.wait(lock, [this]() { return m_Stop || !m_Tasks.empty(); });
+            if (m_Tasks.empty()) { return; }
+
+            const Task task = m_Tasks.back();
+            m_Tasks.pop_back();
+            lock.unlock();
+            Execute(task);
+            lock.lock();
+        }
+    }
+
+private:
+    std::vector<std::thread> m_Threads;
+    std::vector<Task> m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_TaskAvailable;
+    std::condition_variable m_TaskFinished;
+    bool m_Stop = false;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* Sort autotuning header.
+*
+* SortTuner sweeps the SortConfiguration parameters for an element type on the current machine.
+* Each parameter is tuned in turn keeping the best value found for the previous ones.
+* The result can be stored in the global SortProfile and saved to a file, so every machine runs with its own thresholds:
+*
+*   SortConfiguration configuration = SortTuner::Tune<size_t>([](size_t i) { return i * 2654435761u; });
+*   SortProfile::Get().Set(sizeof(size_t), configuration);
+*   SortProfile::Get().Save("sort_profile.txt");
+*
+* Later runs load the profile setting the SORT_PROFILE environment variable or calling SortProfile::Get().Load.
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include <chrono>       //For std::chrono::steady_clock
+#include <functional>   //For std::greater
+#include <initializer_list> //For std::initializer_list
+#include <limits>       //For std::numeric_limits
+#include <thread>       //For std::thread::hardware_concurrency
+#include <vector>       //For std::vector
+
+#include "Sort.hpp"
+
+class SortTuner
+{
+public:
+    /*
+    * Returns the fastest configuration found for sorting vectors of T with the given comparator.
+    * The generator is called as generator(i) for i in [0, size) and has to return the i-th element of the benchmark input.
+    * Each candidate is measured iterations times and the best time is kept.
+    */
+    template<typename T, typename Generator, typename Comparator = std::greater<T>>
+    static SortConfiguration Tune(Generator generator, size_t size = 1 << 20, size_t iterations = 5, Comparator comparator = Comparator()) noexcept
+    {
+        std::vector<T> input;
+        input.reserve(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            input.push_back(generator(i));
+        }
+
+        SortConfiguration best;
+        TuneParameter(input, comparator, iterations, SortAlgorithm::Default, best, &SortConfiguration::LeafCutoff, { 8, 16, 24, 32, 48, 64, 96, 128, 200, 256 });
+        TuneParameter(input, comparator, iterations, SortAlgorithm::Default, best, &SortConfiguration::PivotSample, { 1, 3, 9 });
+        if (std::thread::hardware_concurrency() > 1)
+        {
+            TuneParameter(input, comparator, iterations, SortAlgorithm::Default, best, &SortConfiguration::ParallelGrain, { 0, size_t(1) << 12, size_t(1) << 14, size_t(1) << 16, size_t(1) << 18 });
+        }
+        TuneParameter(input, comparator, iterations, SortAlgorithm::MergeSort, best, &SortConfiguration::MergeTile, { 1, 4, 8, 16, 32, 64 });
+
+        return best;
+    }
+
+private:
+    template<typename T, typename Comparator>
+    static void TuneParameter(const std::vector<T>& input, Comparator comparator, size_t iterations, SortAlgorithm algorithm,
+        SortConfiguration& best, size_t SortConfiguration::* parameter, std::initializer_list<size_t> candidates) noexcept
+    {
+        double best_time = std::numeric_limits<double>::max();
+        size_t best_value = best.*parameter;
+        for (size_t candidate : candidates)
+        {
+            SortConfiguration configuration = best;
+            configuration.*parameter = candidate;
+            const double time = Measure(input, comparator, iterations, algorithm, configuration);
+            if (time < best_time)
+            {
+                best_time = time;
+                best_value = candidate;
+            }
+        }
+        best.*parameter = best_value;
+    }
+
+    template<typename T, typename Comparator>
+    static double Measure(const std::vector<T>& input, Comparator comparator, size_t iterations, SortAlgorithm algorithm, const SortConfiguration& configuration) noexcept
+    {
+        double best_time = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            std::vector<T> vector(input);
+            const auto start = std::chrono::steady_clock::now();
+            Sort<typename std::vector<T>::iterator, Comparator>(vector.begin(), vector.end(), comparator, algorithm, configuration);
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+            if (duration.count() < best_time) { best_time = duration.count(); }
+        }
+        return best_time;
+    }
+};
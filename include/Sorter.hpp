@@ -0,0 +1,286 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* Reusable sorter header.
+*
+* Sorter keeps between calls everything Sort would set up on each one:
+* the configuration for the element size, the scratch memory, which only grows, and an optional pool of worker threads.
+* Once the scratch memory has grown to the size of the containers being sorted, sorting does not allocate memory or create threads.
+* The only exception is Merge Insertion Sort of containers without random access, which keeps an iterator to every element for each call.
+*
+* Sort can be called at the same time from several threads. Each call takes a scratch that no other call is using and gives it back at the end.
+*
+* SortSegments sorts many independent segments of one container in a single call.
+* The segments are grouped by size: up to 8 elements are sorted by sorting networks, up to SortConfiguration::LeafCutoff by InsertionSort and bigger ones by Default Sort.
+* With a thread pool, the groups are split in chunks of similar number of elements that are sorted in parallel.
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include <algorithm>    //For std::max and std::iter_swap
+#include <functional>   //For std::greater
+#include <iterator>     //For std::begin, std::end, std::next, std::distance and std::iterator_traits
+#include <memory>       //For std::unique_ptr
+#include <mutex>        //For std::mutex and std::lock_guard
+#include <type_traits>  //For std::is_same_v
+#include <vector>       //For std::vector
+
+#include "Sort.hpp"
+
+template<typename T, typename Comparator = std::greater<T>>
+class Sorter
+{
+public:
+    template<typename Iterator>
+    void Sort(Iterator begin, Iterator end, SortAlgorithm algorithm = SortAlgorithm::Default) noexcept
+    {
+        static_assert(std::is_same_v<typename std::iterator_traits<Iterator>::value_type, T>, "Sorter can only sort containers of T");
+
+        SortScratch<T>* scratch = AcquireScratch();
+        ::Sort<Iterator, Comparator>(begin, end, m_Comparator, algorithm, m_Configuration, scratch, m_Pool.get());
+        ReleaseScratch(scratch);
+    }
+
+    template<typename Range>
+    void Sort(Range& range, SortAlgorithm algorithm = SortAlgorithm::Default) noexcept
+    {
+        Sort(std::begin(range), std::end(range), algorithm);
+    }
+
+    /*
+    * Sorts each segment [begin + offsets[i], begin + offsets[i + 1]) for every pair of consecutive offsets.
+    * The offsets have to be in ascending order. The elements before the first offset and after the last one are not sorted.
+    */
+    template<typename Iterator, typename OffsetIterator>
+    void SortSegments(Iterator begin, OffsetIterator offsets_begin, OffsetIterator offsets_end) noexcept
+    {
+        static_assert(std::is_same_v<typename std::iterator_traits<Iterator>::value_type, T>, "Sorter can only sort containers of T");
+
+        const size_t offsets_count = std::distance(offsets_begin, offsets_end);
+        if (offsets_count < 2) { return; }
+        const size_t segments_count = offsets_count - 1;
+
+        //Counting sort of the segment indices by their group: sorting network, InsertionSort or Default Sort.
+        SortScratch<T>* scratch = AcquireScratch();
+        std::vector<size_t>& segments = scratch->Segments;
+        segments.resize(segments_count);
+        size_t group_begin[s_SegmentGroups + 1] = {};
+        for (size_t i = 0; i < segments_count; ++i)
+        {
+            ++group_begin[GetSegmentGroup(GetSegmentSize(offsets_begin, i)) + 1];
+        }
+        for (size_t group = 1; group <= s_SegmentGroups; ++group)
+        {
+            group_begin[group] += group_begin[group - 1];
+        }
+        size_t total_size = 0;
+        for (size_t i = 0; i < segments_count; ++i)
+        {
+            const size_t size = GetSegmentSize(offsets_begin, i);
+            segments[group_begin[GetSegmentGroup(size)]++] = i;
+            total_size += size;
+        }
+
+        SegmentsJob<Iterator, OffsetIterator> job{ this, begin, offsets_begin, segments.data() };
+        if (m_Pool == nullptr || total_size < 2 * s_SegmentChunkSize)
+        {
+            SortSegmentsTask<Iterator, OffsetIterator>(&job, 0, segments_count);
+            ReleaseScratch(scratch);
+            return;
+        }
+
+        //Chunks of consecutive segments with at least s_SegmentChunkSize elements, so there are several chunks per thread.
+        const size_t chunk_size = std::max(s_SegmentChunkSize, total_size / (4 * (m_Pool->GetThreadCount() + 1)));
+        SortThreadPool::TaskGroup group;
+        size_t chunk_begin = 0;
+        size_t chunk_elements = 0;
+        for (size_t i = 0; i < segments_count; ++i)
+        {
+            chunk_elements += GetSegmentSize(offsets_begin, segments[i]);
+            if (chunk_elements >= chunk_size)
+            {
+                m_Pool->Submit(group, &SortSegmentsTask<Iterator, OffsetIterator>, &job, chunk_begin, i + 1);
+                chunk_begin = i + 1;
+                chunk_elements = 0;
+            }
+        }
+        if (chunk_begin != segments_count) { SortSegmentsTask<Iterator, OffsetIterator>(&job, chunk_begin, segments_count); }
+        m_Pool->Wait(group);
+        ReleaseScratch(scratch);
+    }
+
+    const SortConfiguration& GetConfiguration() const noexcept { return m_Configuration; }
+
+public:
+    /*
+    * With thread_count different from 0, the sorter owns a pool with that number of worker threads used by the parallel Default Sort.
+    * If the configuration does not set SortConfiguration::ParallelGrain, s_DefaultParallelGrain is used.
+    */
+    explicit Sorter(Comparator comparator = Comparator(), size_t thread_count = 0) noexcept :
+        Sorter(comparator, thread_count, SortProfile::FindGlobal<sizeof(T)>())
+    {
+    }
+
+    Sorter(Comparator comparator, size_t thread_count, const SortConfiguration& configuration) noexcept :
+        m_Comparator(comparator),
+        m_Configuration(configuration)
+    {
+        if (thread_count != 0)
+        {
+            m_Pool = std::make_unique<SortThreadPool>(thread_count);
+            if (m_Configuration.ParallelGrain == 0) { m_Configuration.ParallelGrain = s_DefaultParallelGrain; }
+        }
+    }
+
+    Sorter(const Sorter&) = delete;
+    Sorter& operator=(const Sorter&) = delete;
+
+private:
+    template<typename Iterator, typename OffsetIterator>
+    struct SegmentsJob
+    {
+        Sorter* Owner;
+        Iterator Begin;
+        OffsetIterator Offsets;
+        const size_t* Segments;
+    };
+
+    //Sorts the segments in positions [first, last) of the segments ordered by size.
+    template<typename Iterator, typename OffsetIterator>
+    static void SortSegmentsTask(void* context, size_t first, size_t last) noexcept
+    {
+        const SegmentsJob<Iterator, OffsetIterator>& job = *static_cast<const SegmentsJob<Iterator, OffsetIterator>*>(context);
+        Sorter& sorter = *job.Owner;
+        SortScratch<T>* scratch = nullptr;
+        for (size_t i = first; i < last; ++i)
+        {
+            const size_t segment = job.Segments[i];
+            const size_t size = GetSegmentSize(job.Offsets, segment);
+            const Iterator begin = std::next(job.Begin, *std::next(job.Offsets, segment));
+            const Iterator end = std::next(begin, size);
+            switch (sorter.GetSegmentGroup(size))
+            {
+            case 0:
+                SortNetwork(begin, size, sorter.m_Comparator);
+                break;
+            case 1:
+                ::Sort<Iterator, Comparator>(begin, end, sorter.m_Comparator, SortAlgorithm::InsertionSort, sorter.m_Configuration);
+                break;
+            default:
+                if (scratch == nullptr) { scratch = sorter.AcquireScratch(); }
+                ::Sort<Iterator, Comparator>(begin, end, sorter.m_Comparator, SortAlgorithm::Default, sorter.m_Configuration, scratch);
+                break;
+            }
+        }
+        if (scratch != nullptr) { sorter.ReleaseScratch(scratch); }
+    }
+
+    template<typename OffsetIterator>
+    static size_t GetSegmentSize(OffsetIterator offsets, size_t segment) noexcept
+    {
+        const OffsetIterator offset = std::next(offsets, segment);
+        return static_cast<size_t>(*std::next(offset) - *offset);
+    }
+
+    size_t GetSegmentGroup(size_t size) const noexcept
+    {
+        if (size <= s_MaxNetworkSize) { return 0; }
+        if (size <= m_Configuration.LeafCutoff) { return 1; }
+        return 2;
+    }
+
+    //Optimal sorting networks for up to s_MaxNetworkSize elements.
+    template<typename Iterator>
+    static void SortNetwork(Iterator begin, size_t size, Comparator comparator) noexcept
+    {
+        static constexpr unsigned char s_Network2[][2] = { {0,1} };
+        static constexpr unsigned char s_Network3[][2] = { {1,2}, {0,2}, {0,1} };
+        static constexpr unsigned char s_Network4[][2] = { {0,1}, {2,3}, {0,2}, {1,3}, {1,2} };
+        static constexpr unsigned char s_Network5[][2] = { {0,1}, {3,4}, {2,4}, {2,3}, {0,3}, {0,2}, {1,4}, {1,3}, {1,2} };
+        static constexpr unsigned char s_Network6[][2] = { {1,2}, {4,5}, {0,2}, {3,5}, {0,1}, {3,4}, {1,4}, {0,3}, {2,5}, {1,3}, {2,4}, {2,3} };
+        static constexpr unsigned char s_Network7[][2] = { {1,2}, {3,4}, {5,6}, {0,2}, {3,5}, {4,6}, {0,1}, {4,5}, {2,6}, {0,4}, {1,5}, {0,3}, {2,5}, {1,3}, {2,4}, {2,3} };
+        static constexpr unsigned char s_Network8[][2] = { {0,1}, {2,3}, {4,5}, {6,7}, {0,2}, {1,3}, {4,6}, {5,7}, {1,2}, {5,6}, {0,4}, {3,7}, {1,5}, {2,6}, {1,4}, {3,6}, {2,4}, {3,5}, {3,4} };
+
+        switch (size)
+        {
+        case 2: CompareExchange(begin, s_Network2, comparator); break;
+        case 3: CompareExchange(begin, s_Network3, comparator); break;
+        case 4: CompareExchange(begin, s_Network4, comparator); break;
+        case 5: CompareExchange(begin, s_Network5, comparator); break;
+        case 6: CompareExchange(begin, s_Network6, comparator); break;
+        case 7: CompareExchange(begin, s_Network7, comparator); break;
+        case 8: CompareExchange(begin, s_Network8, comparator); break;
+        default: break;
+        }
+    }
+
+    template<typename Iterator, size_t Size>
+    static void CompareExchange(Iterator begin, const unsigned char (&network)[Size][2], Comparator comparator) noexcept
+    {
+        for (size_t i = 0; i < Size; ++i)
+        {
+            const Iterator first = std::next(begin, network[i][0]);
+            const Iterator second = std::next(begin, network[i][1]);
+            if (comparator(*first, *second)) { std::iter_swap(first, second); }
+        }
+    }
+
+    SortScratch<T>* AcquireScratch() noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_FreeScratches.empty())
+        {
+            m_Scratches.push_back(std::make_unique<SortScratch<T>>());
+            return m_Scratches.back().get();
+        }
+        SortScratch<T>* scratch = m_FreeScratches.back();
+        m_FreeScratches.pop_back();
+        return scratch;
+    }
+
+    void ReleaseScratch(SortScratch<T>* scratch) noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_FreeScratches.push_back(scratch);
+    }
+
+private:
+    static constexpr size_t s_DefaultParallelGrain = size_t(1) << 16;
+    static constexpr size_t s_MaxNetworkSize = 8;
+    static constexpr size_t s_SegmentGroups = 3;
+    static constexpr size_t s_SegmentChunkSize = size_t(1) << 14;
+
+    Comparator m_Comparator;
+    SortConfiguration m_Configuration;
+    std::unique_ptr<SortThreadPool> m_Pool;
+    std::vector<std::unique_ptr<SortScratch<T>>> m_Scratches;   //Every scratch created, one per concurrent call.
+    std::vector<SortScratch<T>*> m_FreeScratches;               //Scratches not in use.
+    std::mutex m_Mutex;
+};
@@ -1,3 +1,9 @@
+newoption
+{
+    trigger = "with-tbb",
+    description = "Link TBB to benchmark std::sort with std::execution::par outside MSVC"
+}
+
 workspace "Sort"
     platforms
     {
@@ -43,6 +49,13 @@ project "Sort"
         "include"
     }
 
+    filter "system:linux"
+        links { "pthread" }
+
+    filter "options:with-tbb"
+        defines { "SORT_PARALLEL_STL" }
+        links { "tbb" }
+
     filter "configurations:Debug"
         runtime "Debug"
         symbols "On"
@@ -0,0 +1,265 @@
+#include "Benchmark.hpp"
+#include "Timer.hpp"
+
+#include <iostream>     //For std::cout
+#include <fstream>      //For std::ofstream
+#include <random>       //For std::random_device and std::mt19937_64
+#include <algorithm>    //For std::sort, std::stable_sort, std::is_sorted and std::min
+#include <functional>   //For std::greater
+#include <filesystem>   //For std::filesystem::create_directories
+#include <thread>       //For std::thread::hardware_concurrency
+#include <cmath>        //For INFINITY, std::lgamma and std::log
+#include <cstdint>      //For SIZE_MAX
+#include <memory>       //For std::unique_ptr and std::make_unique
+
+//std::execution::par needs TBB with libstdc++, so outside MSVC it is only used when building with SORT_PARALLEL_STL (premake option --with-tbb).
+#if defined(_MSC_VER) || defined(SORT_PARALLEL_STL)
+#include <execution>    //For std::execution::par
+#endif
+
+//With TBB the threads of std::execution::par can be limited, so it runs for every thread count. The MSVC one always uses all the hardware threads.
+#if defined(SORT_PARALLEL_STL) && !defined(_MSC_VER)
+#include <optional>     //For std::optional
+#include <tbb/global_control.h> //For tbb::global_control
+#define SORT_PARALLEL_STL_THREADS
+#endif
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>    //For GlobalMemoryStatusEx
+#else
+#include <unistd.h>     //For sysconf
+#endif
+
+static constexpr size_t s_QuadraticMaxSize = 100000;
+static constexpr size_t s_SingleRunSize = 100000000;   //Containers of this size or bigger are sorted only once.
+static constexpr size_t s_ParallelGrain = size_t(1) << 16;
+
+template<SortAlgorithm Algorithm>
+static void RunSort(std::vector<size_t>& vector, SortThreadPool* pool) noexcept
+{
+    SortConfiguration configuration = SortProfile::Get().Find(sizeof(size_t));
+    if (pool != nullptr && configuration.ParallelGrain == 0) { configuration.ParallelGrain = s_ParallelGrain; }
+    Sort(vector.begin(), vector.end(), std::greater<size_t>(), Algorithm, configuration, nullptr, pool);
+}
+
+//std::greater that counts its calls.
+struct CountingGreater
+{
+    size_t* Count;
+
+    bool operator()(size_t first, size_t second) const noexcept
+    {
+        ++*Count;
+        return first > second;
+    }
+};
+
+template<SortAlgorithm Algorithm>
+static size_t CountSort(std::vector<size_t>& vector) noexcept
+{
+    size_t count = 0;
+    Sort(vector.begin(), vector.end(), CountingGreater{ &count }, Algorithm);
+    return count;
+}
+
+void Benchmark::RunScalingSuite(size_t max_exponent, size_t iterations) noexcept
+{
+    const size_t hardware_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    std::vector<Contender> contenders =
+    {
+        { "Default Sort", &RunSort<SortAlgorithm::Default>, SIZE_MAX, 0, sizeof(size_t) },
+        { "Bubble Sort", &RunSort<SortAlgorithm::BubbleSort>, s_QuadraticMaxSize, 1, 0 },
+        { "Selection Sort", &RunSort<SortAlgorithm::SelectionSort>, s_QuadraticMaxSize, 1, 0 },
+        { "Insertion Sort", &RunSort<SortAlgorithm::InsertionSort>, s_QuadraticMaxSize, 1, 0 },
+        { "Merge Sort", &RunSort<SortAlgorithm::MergeSort>, SIZE_MAX, 1, sizeof(size_t) },
+        { "Quick Sort", &RunSort<SortAlgorithm::QuickSort>, SIZE_MAX, 1, 0 },
+        { "Learned Sort", &RunSort<SortAlgorithm::LearnedSort>, SIZE_MAX, 1, sizeof(size_t) },
+        { "Merge Insertion Sort", &RunSort<SortAlgorithm::MergeInsertionSort>, SIZE_MAX, 1, sizeof(std::vector<size_t>::iterator) + 2 * sizeof(size_t) },
+        { "std::sort", [](std::vector<size_t>& vector, SortThreadPool*) { std::sort(vector.begin(), vector.end()); }, SIZE_MAX, 1, 0 },
+        { "std::stable_sort", [](std::vector<size_t>& vector, SortThreadPool*) { std::stable_sort(vector.begin(), vector.end()); }, SIZE_MAX, 1, sizeof(size_t) }
+    };
+#if (defined(_MSC_VER) || defined(SORT_PARALLEL_STL)) && defined(__cpp_lib_parallel_algorithm)
+#ifdef SORT_PARALLEL_STL_THREADS
+    constexpr size_t parallel_stl_threads = 0;
+#else
+    const size_t parallel_stl_threads = hardware_threads;
+    std::cout << "std::sort(par) can not limit its threads without TBB, it only runs with all the " << hardware_threads << " hardware threads." << std::endl;
+#endif
+    contenders.push_back({ "std::sort(par)", [](std::vector<size_t>& vector, SortThreadPool*) { std::sort(std::execution::par, vector.begin(), vector.end()); }, SIZE_MAX, parallel_stl_threads, sizeof(size_t) });
+#endif
+
+    //1, 2, 4... and the number of hardware threads.
+    std::vector<size_t> thread_counts;
+    for (size_t threads = 1; threads < hardware_threads; threads *= 2) { thread_counts.push_back(threads); }
+    thread_counts.push_back(hardware_threads);
+
+    //The input, the copy being sorted and the scratch memory of the hungriest sort must fit in half of the memory.
+    size_t max_scratch = 0;
+    for (const Contender& contender : contenders) { max_scratch = std::max(max_scratch, contender.ScratchPerElement); }
+    const size_t memory = GetPhysicalMemory();
+    const size_t max_size = memory != 0 ? memory / 2 / (2 * sizeof(size_t) + max_scratch) : SIZE_MAX;
+
+    std::vector<Result> results;
+    std::mt19937_64 mt(std::random_device{}());
+    size_t size = 1;
+    for (size_t exponent = 1; exponent <= max_exponent; ++exponent)
+    {
+        size *= 10;
+        if (size > max_size)
+        {
+            std::cout << "Size " << size << " does not fit in memory, stopping." << std::endl;
+            break;
+        }
+
+        std::vector<size_t> input(size);
+        for (size_t& value : input) { value = mt(); }
+        const size_t runs = size >= s_SingleRunSize ? 1 : iterations;
+
+        for (const Contender& contender : contenders)
+        {
+            if (size > contender.MaxSize) { continue; }
+            if (contender.Threads != 0)
+            {
+                results.push_back(Measure(contender, contender.Threads, input, runs));
+                continue;
+            }
+            for (const size_t threads : thread_counts)
+            {
+                results.push_back(Measure(contender, threads, input, runs));
+            }
+        }
+
+        //Written after every size, so the curves can be plotted while the biggest sizes are still running.
+        WriteThroughput("data/Scaling_Throughput.csv", results);
+        WriteSpeedup("data/Scaling_Speedup.csv", results);
+    }
+}
+
+void Benchmark::RunComparisonSuite(size_t max_exponent) noexcept
+{
+    const std::vector<CountingContender> contenders =
+    {
+        { "Default Sort", &CountSort<SortAlgorithm::Default>, SIZE_MAX },
+        { "Bubble Sort", &CountSort<SortAlgorithm::BubbleSort>, s_QuadraticMaxSize },
+        { "Selection Sort", &CountSort<SortAlgorithm::SelectionSort>, s_QuadraticMaxSize },
+        { "Insertion Sort", &CountSort<SortAlgorithm::InsertionSort>, s_QuadraticMaxSize },
+        { "Merge Sort", &CountSort<SortAlgorithm::MergeSort>, SIZE_MAX },
+        { "Quick Sort", &CountSort<SortAlgorithm::QuickSort>, SIZE_MAX },
+        { "Learned Sort", &CountSort<SortAlgorithm::LearnedSort>, SIZE_MAX },
+        { "Merge Insertion Sort", &CountSort<SortAlgorithm::MergeInsertionSort>, SIZE_MAX },
+        { "std::sort", [](std::vector<size_t>& vector) { size_t count = 0; std::sort(vector.begin(), vector.end(), [&](size_t first, size_t second) { ++count; return first < second; }); return count; }, SIZE_MAX },
+        { "std::stable_sort", [](std::vector<size_t>& vector) { size_t count = 0; std::stable_sort(vector.begin(), vector.end(), [&](size_t first, size_t second) { ++count; return first < second; }); return count; }, SIZE_MAX }
+    };
+
+    std::filesystem::create_directories("data");
+    std::ofstream file("data/Comparisons.csv", std::ios::out | std::ios::trunc);
+    file << "algorithm,size,comparisons_per_element,lower_bound_per_element\n";
+
+    std::mt19937_64 mt(std::random_device{}());
+    size_t size = 1;
+    for (size_t exponent = 1; exponent <= max_exponent; ++exponent)
+    {
+        size *= 10;
+        std::vector<size_t> input(size);
+        for (size_t& value : input) { value = mt(); }
+
+        //log2(n!) = ln(Gamma(n + 1)) / ln(2).
+        const double lower_bound = std::lgamma(static_cast<double>(size) + 1.0) / std::log(2.0) / static_cast<double>(size);
+        std::cout << "Comparisons per element for size " << size << ", lower bound " << lower_bound << std::endl;
+        std::vector<size_t> vector;
+        for (const CountingContender& contender : contenders)
+        {
+            if (size > contender.MaxSize) { continue; }
+            vector = input;
+            const double comparisons = static_cast<double>(contender.Function(vector)) / static_cast<double>(size);
+            std::cout << "\t" << contender.Name << ": " << comparisons << (std::is_sorted(vector.begin(), vector.end()) ? "" : " (Test failed!)") << std::endl;
+            file << contender.Name << ',' << size << ',' << comparisons << ',' << lower_bound << '\n';
+        }
+    }
+}
+
+Benchmark::Result Benchmark::Measure(const Contender& contender, size_t threads, const std::vector<size_t>& input, size_t iterations) noexcept
+{
+    std::cout << contender.Name << " with " << threads << (threads == 1 ? " thread" : " threads") << " and size " << input.size() << std::endl;
+
+    //The pool has one thread less, the calling thread also sorts while it waits.
+    std::unique_ptr<SortThreadPool> pool;
+    if (contender.Threads == 0 && threads > 1) { pool = std::make_unique<SortThreadPool>(threads - 1); }
+#ifdef SORT_PARALLEL_STL_THREADS
+    //Limits the threads of std::execution::par. The sorts of this library do not use TBB, so it does not change them.
+    std::optional<tbb::global_control> parallel_stl_threads;
+    if (contender.Threads == 0) { parallel_stl_threads.emplace(tbb::global_control::max_allowed_parallelism, threads); }
+#endif
+
+    Result result;
+    result.Name = contender.Name;
+    result.Threads = threads;
+    result.Size = input.size();
+    result.Best = INFINITY;
+    std::vector<size_t> vector;
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        vector = input;
+        Timer timer;
+        timer.Start();
+        contender.Function(vector, pool.get());
+        const double time = timer.Stop();
+        result.Best = std::min(result.Best, time);
+        result.Average += time / static_cast<double>(iterations);
+        if (!std::is_sorted(vector.begin(), vector.end())) { std::cout << "\tTest failed!" << std::endl; }
+    }
+    return result;
+}
+
+void Benchmark::WriteThroughput(const std::string& path, const std::vector<Result>& results) noexcept
+{
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    file << "algorithm,threads,size,best_seconds,average_seconds,million_elements_per_second\n";
+    for (const Result& result : results)
+    {
+        file << result.Name << ',' << result.Threads << ',' << result.Size << ',' << result.Best << ',' << result.Average << ','
+            << static_cast<double>(result.Size) / result.Best / 1.0e6 << '\n';
+    }
+}
+
+//Speedup of every result against std::sort and against the same algorithm with one thread, both for the same size.
+void Benchmark::WriteSpeedup(const std::string& path, const std::vector<Result>& results) noexcept
+{
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    file << "algorithm,threads,size,speedup_vs_std_sort,speedup_vs_one_thread\n";
+    for (const Result& result : results)
+    {
+        double std_sort = 0.0;
+        double one_thread = result.Threads == 1 ? result.Best : 0.0;
+        for (const Result& other : results)
+        {
+            if (other.Size != result.Size) { continue; }
+            if (other.Name == "std::sort") { std_sort = other.Best; }
+            if (other.Name == result.Name && other.Threads == 1) { one_thread = other.Best; }
+        }
+
+        file << result.Name << ',' << result.Threads << ',' << result.Size << ',';
+        if (std_sort > 0.0) { file << std_sort / result.Best; }
+        file << ',';
+        if (one_thread > 0.0) { file << one_thread / result.Best; }
+        file << '\n';
+    }
+}
+
+size_t Benchmark::GetPhysicalMemory() noexcept
+{
+#ifdef _WIN32
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (!GlobalMemoryStatusEx(&status)) { return 0; }
+    return static_cast<size_t>(status.ullTotalPhys);
+#else
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long page_size = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || page_size <= 0) { return 0; }
+    return static_cast<size_t>(pages) * static_cast<size_t>(page_size);
+#endif
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* Scaling benchmark. The console application runs it, and the comparison benchmark after it, when it gets --benchmark.
+*
+* Runs every SortAlgorithm and the standard library sorts (std::sort, std::stable_sort and std::sort with std::execution::par when available)
+* on random containers from 10 elements up to 10^max_exponent, as long as three copies of the container fit in half of the physical memory.
+* Default Sort is also run with a SortThreadPool for every thread count from 1 to the number of hardware threads, and so is std::sort with std::execution::par
+* when it runs on TBB (premake option --with-tbb), limiting its threads with tbb::global_control. Otherwise it only runs with all the hardware threads.
+* The results are written as CSV files ready to plot:
+* data/Scaling_Throughput.csv: algorithm,threads,size,best_seconds,average_seconds,million_elements_per_second
+* data/Scaling_Speedup.csv: algorithm,threads,size,speedup_vs_std_sort,speedup_vs_one_thread
+*
+* Comparison benchmark.
+*
+* Counts the calls to the comparator of every SortAlgorithm and the standard library sorts on random containers from 10 elements up to 10^max_exponent,
+* next to the lower bound of any comparison sort, log2(n!) comparisons.
+* data/Comparisons.csv: algorithm,size,comparisons_per_element,lower_bound_per_element
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include "Sort.hpp"
+#include <string>
+#include <vector>
+
+class Benchmark
+{
+public:
+    static void RunScalingSuite(size_t max_exponent = 9, size_t iterations = 3) noexcept;
+    static void RunComparisonSuite(size_t max_exponent = 6) noexcept;
+
+private:
+    //Sorts the container. The pool is null when the sort runs on a single thread.
+    using SortFunction = void(*)(std::vector<size_t>& vector, SortThreadPool* pool);
+
+    struct Contender
+    {
+        const char* Name;
+        SortFunction Function;
+        size_t MaxSize;             //Quadratic sorts are only run up to this size.
+        size_t Threads;             //Threads used by the sort. 0 runs it for every thread count, with a SortThreadPool or a TBB thread limit.
+        size_t ScratchPerElement;   //Bytes of scratch memory per element, to keep the biggest sizes within the memory.
+    };
+
+    //Sorts the container and returns the number of calls to the comparator.
+    using CountingFunction = size_t(*)(std::vector<size_t>& vector);
+
+    struct CountingContender
+    {
+        const char* Name;
+        CountingFunction Function;
+        size_t MaxSize;
+    };
+
+    struct Result
+    {
+        std::string Name;
+        size_t Threads = 1;
+        size_t Size = 0;
+        double Best = 0.0;
+        double Average = 0.0;
+    };
+
+private:
+    static Result Measure(const Contender& contender, size_t threads, const std::vector<size_t>& input, size_t iterations) noexcept;
+    static void WriteThroughput(const std::string& path, const std::vector<Result>& results) noexcept;
+    static void WriteSpeedup(const std::string& path, const std::vector<Result>& results) noexcept;
+    static size_t GetPhysicalMemory() noexcept;
+};
@@ -1,6 +1,22 @@
 #include "Test.hpp"
+#include "Benchmark.hpp"
+#include "TextSort.hpp"
 
-int main()
+#include <cstring>  //For std::strcmp
+
+int main(int argc, char** argv)
 {
-    Test::RunAllTests();
+    //--run-tests runs the tests and --benchmark the benchmarks. Anything else, no arguments included, sorts text like sort does, so the standard input can be piped in.
+    if (argc == 2 && std::strcmp(argv[1], "--run-tests") == 0)
+    {
+        Test::RunAllTests();
+        return 0;
+    }
+    if (argc == 2 && std::strcmp(argv[1], "--benchmark") == 0)
+    {
+        Benchmark::RunScalingSuite();
+        Benchmark::RunComparisonSuite();
+        return 0;
+    }
+    return TextSort::Run(argc, argv);
 }
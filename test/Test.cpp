@@ -1,5 +1,13 @@
 #include "Test.hpp"
 #include "Timer.hpp"
+#include "SortTuner.hpp"
+#include "Sorter.hpp"
+#include "RecordSort.hpp"
+#include "KWayMerge.hpp"
+#include "SortReduce.hpp"
+#include "NormalizedKey.hpp"
+#include "LazySortedView.hpp"
+#include "SharedMemorySort.hpp"
 
 #include <iostream> //For std::cout and std::fixed
 #include <iomanip>  //For std::setprecision
@@ -7,6 +15,11 @@
 #include <sstream>  //For std::stringstream
 #include <fstream>  //For std::ofstream
 #include <string>   //For std::string
+#include <cstring>  //For strlen
+#include <cmath>    //For INFINITY
+#include <cstdint>  //For std::uint32_t and std::uint64_t
+#include <algorithm> //For std::unique, std::sort, std::max and std::fill
+#include <limits>   //For std::numeric_limits
 
 struct Comparison
 {
@@ -20,6 +33,33 @@ struct Comparison
     double Worst = 0.0;
 };
 
+//256 bytes record that counts the bytes moved or copied.
+struct LargeRecord
+{
+    size_t Key = 0;
+    char Payload[248] = {};
+
+    static size_t s_BytesMoved;
+
+    LargeRecord() noexcept { }
+    explicit LargeRecord(size_t key) noexcept : Key(key) { }
+    LargeRecord(const LargeRecord& other) noexcept { Assign(other); }
+    LargeRecord(LargeRecord&& other) noexcept { Assign(other); }
+    LargeRecord& operator=(const LargeRecord& other) noexcept { Assign(other); return *this; }
+    LargeRecord& operator=(LargeRecord&& other) noexcept { Assign(other); return *this; }
+
+    bool operator>(const LargeRecord& other) const noexcept { return Key > other.Key; }
+
+private:
+    void Assign(const LargeRecord& other) noexcept
+    {
+        std::memcpy(this, &other, sizeof(LargeRecord));
+        s_BytesMoved += sizeof(LargeRecord);
+    }
+};
+
+size_t LargeRecord::s_BytesMoved = 0;
+
 static size_t g_ITERATIONS = 10;
 static size_t g_ARRAYSIZE = 4; // 1->10, 2->100, 3->1000...
 static std::stringstream s_FileBuffer;
@@ -176,6 +216,8 @@ void Test::RunAllTests() noexcept
     RunMergeSortTest();
     RunQuickSortTest();
     RunDefaultSortTest();
+    RunLearnedSortTest();
+    RunMergeInsertionSortTest();
 
     SerializeComparison();
 }
@@ -195,6 +237,527 @@ void Test::QuickVSDefault() noexcept
     SerializeComparison();
 }
 
+void Test::Autotune() noexcept
+{
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_int_distribution<size_t> dist;
+
+    std::cout << "Autotuning size_t sort configuration" << std::endl;
+    const SortConfiguration configuration = SortTuner::Tune<size_t>([&](size_t) { return dist(mt); });
+    std::cout << "\tLeaf cutoff: " << configuration.LeafCutoff << std::endl;
+    std::cout << "\tPivot sample: " << configuration.PivotSample << std::endl;
+    std::cout << "\tParallel grain: " << configuration.ParallelGrain << std::endl;
+    std::cout << "\tMerge tile: " << configuration.MergeTile << std::endl;
+
+    SortProfile::Get().Set(sizeof(size_t), configuration);
+    SortProfile::Get().Save("data/sort_profile.txt");
+}
+
+void Test::SorterVSSort() noexcept
+{
+    constexpr size_t vectors = 1000;
+    constexpr size_t vector_size = 10000;
+
+    std::vector<std::vector<size_t>> inputs(vectors);
+    for (std::vector<size_t>& input : inputs)
+    {
+        input.reserve(vector_size);
+        FillRandom(input, vector_size);
+    }
+
+    Sorter<size_t> sorter;
+    Sorter<size_t> parallel_sorter(std::greater<size_t>(), std::thread::hardware_concurrency());
+    for (SortAlgorithm algorithm : { SortAlgorithm::Default, SortAlgorithm::MergeSort })
+    {
+        const char* name = algorithm == SortAlgorithm::Default ? "Default Sort" : "Merge Sort";
+        double sort_time = 0.0;
+        double sorter_time = 0.0;
+        double parallel_sorter_time = 0.0;
+        bool sorted = true;
+        for (const std::vector<size_t>& input : inputs)
+        {
+            std::vector<size_t> vector(input);
+            Timer timer;
+            timer.Start();
+            Sort(vector.begin(), vector.end(), std::greater<size_t>(), algorithm);
+            sort_time += timer.Stop();
+            sorted = sorted && CheckVector(vector);
+
+            vector = input;
+            timer.Start();
+            sorter.Sort(vector, algorithm);
+            sorter_time += timer.Stop();
+            sorted = sorted && CheckVector(vector);
+
+            vector = input;
+            timer.Start();
+            parallel_sorter.Sort(vector, algorithm);
+            parallel_sorter_time += timer.Stop();
+            sorted = sorted && CheckVector(vector);
+        }
+
+        std::cout << name << " of " << vectors << " vectors of size " << vector_size << (sorted ? "" : " (Test failed!)") << std::endl;
+        std::cout << "\tSort:              " << std::fixed << std::setprecision(6) << sort_time << " seconds" << std::endl;
+        std::cout << "\tSorter:            " << std::fixed << std::setprecision(6) << sorter_time << " seconds" << std::endl;
+        std::cout << "\tParallel Sorter:   " << std::fixed << std::setprecision(6) << parallel_sorter_time << " seconds" << std::endl;
+    }
+}
+
+void Test::SegmentedVSSort() noexcept
+{
+    constexpr size_t total_size = 10000000;
+
+    //Segments of 10 to 500 elements.
+    std::random_device rd;
+    std::mt19937 mt(rd());
+    std::uniform_int_distribution<size_t> segment_size(10, 500);
+    std::vector<size_t> offsets{ 0 };
+    while (offsets.back() < total_size)
+    {
+        offsets.push_back(std::min(offsets.back() + segment_size(mt), total_size));
+    }
+
+    std::vector<size_t> input;
+    input.reserve(total_size);
+    FillRandom(input, total_size);
+
+    std::vector<size_t> vector(input);
+    Timer timer;
+    timer.Start();
+    for (size_t i = 0; i + 1 < offsets.size(); ++i)
+    {
+        Sort(vector.begin() + offsets[i], vector.begin() + offsets[i + 1], std::greater<size_t>());
+    }
+    const double sort_time = timer.Stop();
+
+    Sorter<size_t> sorter(std::greater<size_t>(), std::thread::hardware_concurrency());
+    vector = input;
+    timer.Start();
+    sorter.SortSegments(vector.begin(), offsets.begin(), offsets.end());
+    const double segmented_time = timer.Stop();
+    bool sorted = true;
+    for (size_t i = 0; i + 1 < offsets.size() && sorted; ++i)
+    {
+        sorted = std::is_sorted(vector.begin() + offsets[i], vector.begin() + offsets[i + 1]);
+    }
+
+    vector = input;
+    timer.Start();
+    sorter.Sort(vector);
+    const double contiguous_time = timer.Stop();
+
+    std::cout << "Segmented sort of " << offsets.size() - 1 << " segments with " << total_size << " elements" << (sorted ? "" : " (Test failed!)") << std::endl;
+    std::cout << "\tSort per segment:  " << std::fixed << std::setprecision(6) << sort_time << " seconds" << std::endl;
+    std::cout << "\tSortSegments:      " << std::fixed << std::setprecision(6) << segmented_time << " seconds" << std::endl;
+    std::cout << "\tContiguous Sort:   " << std::fixed << std::setprecision(6) << contiguous_time << " seconds" << std::endl;
+}
+
+void Test::LargeRecordTest() noexcept
+{
+    constexpr size_t vector_size = 200000;
+
+    std::vector<size_t> keys;
+    keys.reserve(vector_size);
+    FillRandom(keys, vector_size);
+    std::vector<LargeRecord> input;
+    input.reserve(vector_size);
+    for (size_t key : keys)
+    {
+        input.emplace_back(key);
+    }
+
+    std::cout << "Large record (" << sizeof(LargeRecord) << " bytes) test with size: " << vector_size << std::endl;
+    const auto run = [&](const char* name, auto sort)
+    {
+        std::vector<LargeRecord> vector(input);
+        LargeRecord::s_BytesMoved = 0;
+        Timer timer;
+        timer.Start();
+        sort(vector);
+        const double time = timer.Stop();
+        const bool sorted = std::is_sorted(vector.begin(), vector.end(), [](const LargeRecord& first, const LargeRecord& second) { return first.Key < second.Key; });
+        std::cout << "\t" << name << ": " << std::fixed << std::setprecision(6) << time << " seconds, "
+            << LargeRecord::s_BytesMoved / (1024 * 1024) << " MB moved" << (sorted ? "" : " (Test failed!)") << std::endl;
+    };
+
+    run("Default Sort", [](std::vector<LargeRecord>& vector) { Sort(vector.begin(), vector.end(), std::greater<LargeRecord>()); });
+    run("Merge Sort  ", [](std::vector<LargeRecord>& vector) { Sort(vector.begin(), vector.end(), std::greater<LargeRecord>(), SortAlgorithm::MergeSort); });
+    run("Record Sort ", [](std::vector<LargeRecord>& vector)
+    {
+        RecordSort(vector.begin(), vector.end(), [](const LargeRecord& record) { return record.Key; }, std::greater<size_t>());
+    });
+}
+
+void Test::KWayMergeTest() noexcept
+{
+    constexpr size_t shards = 16;
+    constexpr size_t shard_size = 1000000;
+
+    std::vector<std::vector<size_t>> inputs(shards);
+    std::vector<std::pair<std::vector<size_t>::const_iterator, std::vector<size_t>::const_iterator>> ranges;
+    for (std::vector<size_t>& input : inputs)
+    {
+        input.reserve(shard_size);
+        FillRandom(input, shard_size);
+        Sort(input.begin(), input.end(), std::greater<size_t>());
+        ranges.emplace_back(input.cbegin(), input.cend());
+    }
+
+    std::vector<size_t> vector;
+    vector.reserve(shards * shard_size);
+    Timer timer;
+    timer.Start();
+    for (const std::vector<size_t>& input : inputs)
+    {
+        vector.insert(vector.end(), input.begin(), input.end());
+    }
+    Sort(vector.begin(), vector.end(), std::greater<size_t>(), SortAlgorithm::MergeSort);
+    const double merge_sort_time = timer.Stop();
+    bool sorted = CheckVector(vector);
+    const std::vector<size_t> expected = vector;
+
+    //The output is overwritten with a value the shards do not have, so an element the merges do not write is found.
+    const size_t sentinel = std::numeric_limits<size_t>::max();
+    std::fill(vector.begin(), vector.end(), sentinel);
+    timer.Start();
+    KWayMerge::Merge(ranges, vector.begin(), std::greater<size_t>());
+    const double merge_time = timer.Stop();
+    sorted = sorted && vector == expected;
+
+    std::fill(vector.begin(), vector.end(), sentinel);
+    SortThreadPool pool(std::thread::hardware_concurrency());
+    timer.Start();
+    KWayMerge::ParallelMerge(ranges, vector.begin(), std::greater<size_t>(), pool);
+    const double parallel_merge_time = timer.Stop();
+    sorted = sorted && vector == expected;
+
+    std::cout << "Merge of " << shards << " sorted shards of size " << shard_size << (sorted ? "" : " (Test failed!)") << std::endl;
+    std::cout << "\tConcatenate and Merge Sort: " << std::fixed << std::setprecision(6) << merge_sort_time << " seconds" << std::endl;
+    std::cout << "\tK-way merge:                " << std::fixed << std::setprecision(6) << merge_time << " seconds" << std::endl;
+    std::cout << "\tParallel k-way merge:       " << std::fixed << std::setprecision(6) << parallel_merge_time << " seconds" << std::endl;
+}
+
+void Test::SortReduceTest() noexcept
+{
+    constexpr size_t size = 10000000;
+    constexpr size_t distinct = 100;
+
+    //Few distinct values spread over the whole range, so Default Sort can not sort them by counting.
+    std::mt19937_64 mt(std::random_device{}());
+    std::vector<size_t> values(distinct);
+    for (size_t& value : values) { value = mt(); }
+    std::vector<size_t> input;
+    input.reserve(size);
+    for (size_t i = 0; i < size; ++i) { input.push_back(values[mt() % distinct]); }
+
+    std::vector<size_t> vector = input;
+    Timer timer;
+    timer.Start();
+    Sort(vector.begin(), vector.end(), std::greater<size_t>());
+    vector.erase(std::unique(vector.begin(), vector.end()), vector.end());
+    const double unique_time = timer.Stop();
+    const size_t unique_size = vector.size();
+    bool sorted = CheckVector(vector);
+
+    vector = input;
+    timer.Start();
+    vector.erase(SortReduce::Unique(vector.begin(), vector.end(), std::greater<size_t>()), vector.end());
+    const double fused_unique_time = timer.Stop();
+    sorted = sorted && CheckVector(vector) && vector.size() == unique_size;
+
+    std::vector<size_t> counts;
+    counts.reserve(distinct);
+    vector = input;
+    timer.Start();
+    Sort(vector.begin(), vector.end(), std::greater<size_t>());
+    for (auto current = vector.begin(); current != vector.end();)
+    {
+        const auto group_end = std::upper_bound(current, vector.end(), *current);
+        counts.push_back(std::distance(current, group_end));
+        current = group_end;
+    }
+    const double count_time = timer.Stop();
+
+    std::vector<size_t> fused_counts;
+    fused_counts.reserve(distinct);
+    vector = input;
+    timer.Start();
+    vector.erase(SortReduce::Count(vector.begin(), vector.end(), std::back_inserter(fused_counts), std::greater<size_t>()), vector.end());
+    const double fused_count_time = timer.Stop();
+    sorted = sorted && CheckVector(vector) && counts == fused_counts;
+
+    std::cout << "Sort and reduce of size " << size << " with " << distinct << " distinct values" << (sorted ? "" : " (Test failed!)") << std::endl;
+    std::cout << "\tSort and std::unique:   " << std::fixed << std::setprecision(6) << unique_time << " seconds" << std::endl;
+    std::cout << "\tSortReduce::Unique:     " << std::fixed << std::setprecision(6) << fused_unique_time << " seconds" << std::endl;
+    std::cout << "\tSort and count pass:    " << std::fixed << std::setprecision(6) << count_time << " seconds" << std::endl;
+    std::cout << "\tSortReduce::Count:      " << std::fixed << std::setprecision(6) << fused_count_time << " seconds" << std::endl;
+}
+
+void Test::NormalizedKeyTest() noexcept
+{
+    constexpr size_t size = 4000000;
+
+    struct Row
+    {
+        int Region;
+        double Timestamp;
+        size_t Id;
+    };
+    using Key = NormalizedKey<sizeof(int) + sizeof(double) + sizeof(size_t)>;
+    using KeyIndex = std::pair<Key, size_t>;
+
+    //(region asc, timestamp desc, id asc)
+    const auto row_comparator = [](const Row& first, const Row& second)
+    {
+        if (first.Region != second.Region) { return first.Region > second.Region; }
+        if (first.Timestamp != second.Timestamp) { return first.Timestamp < second.Timestamp; }
+        return first.Id > second.Id;
+    };
+
+    std::mt19937_64 mt(std::random_device{}());
+    std::uniform_real_distribution<double> timestamps(-1.0e6, 1.0e6);
+    std::vector<Row> rows;
+    std::vector<size_t> integers;
+    rows.reserve(size);
+    integers.reserve(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        rows.push_back({ static_cast<int>(mt() % 64) - 32, timestamps(mt), mt() });
+        integers.push_back(mt());
+    }
+
+    Timer timer;
+    timer.Start();
+    Sort(integers.begin(), integers.end(), std::greater<size_t>());
+    const double integer_time = timer.Stop();
+    bool sorted = CheckVector(integers);
+
+    std::vector<Row> vector = rows;
+    timer.Start();
+    Sort(vector.begin(), vector.end(), row_comparator);
+    const double comparator_time = timer.Stop();
+    for (size_t i = 1; i < vector.size() && sorted; ++i)
+    {
+        sorted = !row_comparator(vector[i - 1], vector[i]);
+    }
+
+    const auto encode = [&](std::vector<KeyIndex>& keys)
+    {
+        keys.resize(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            KeyEncoder<sizeof(Key::Bytes)>(keys[i].first).Add(rows[i].Region).Add(rows[i].Timestamp, KeyOrder::Descending).Add(rows[i].Id);
+            keys[i].second = i;
+        }
+    };
+    const auto check_keys = [&](const std::vector<KeyIndex>& keys)
+    {
+        for (size_t i = 1; i < keys.size(); ++i)
+        {
+            if (row_comparator(rows[keys[i - 1].second], rows[keys[i].second])) { return false; }
+        }
+        return true;
+    };
+
+    std::vector<KeyIndex> keys;
+    timer.Start();
+    encode(keys);
+    Sort(keys.begin(), keys.end(), [](const KeyIndex& first, const KeyIndex& second) { return first.first > second.first; });
+    const double memcmp_time = timer.Stop();
+    sorted = sorted && check_keys(keys);
+
+    timer.Start();
+    encode(keys);
+    NormalizedKeySort::RadixSort(keys.begin(), keys.end(), [](const KeyIndex& key) -> const Key& { return key.first; });
+    const double radix_time = timer.Stop();
+    sorted = sorted && check_keys(keys);
+
+    std::cout << "Sort of size " << size << " by (int asc, double desc, size_t asc)" << (sorted ? "" : " (Test failed!)") << std::endl;
+    std::cout << "\tSingle size_t column:         " << std::fixed << std::setprecision(6) << integer_time << " seconds" << std::endl;
+    std::cout << "\tRows with column comparator:  " << std::fixed << std::setprecision(6) << comparator_time << " seconds" << std::endl;
+    std::cout << "\tEncoded keys with memcmp:     " << std::fixed << std::setprecision(6) << memcmp_time << " seconds" << std::endl;
+    std::cout << "\tEncoded keys with radix sort: " << std::fixed << std::setprecision(6) << radix_time << " seconds" << std::endl;
+}
+
+void Test::LearnedSortTest() noexcept
+{
+    constexpr size_t size = 10000000;
+    constexpr size_t zipf_values = 1000000;
+
+    std::mt19937_64 mt(std::random_device{}());
+    std::vector<double> uniform;
+    std::vector<double> normal;
+    std::vector<double> zipf;
+    uniform.reserve(size);
+    normal.reserve(size);
+    zipf.reserve(size);
+    std::uniform_real_distribution<double> uniform_distribution(0.0, 1.0e9);
+    std::normal_distribution<double> normal_distribution(0.0, 1.0e6);
+    for (size_t i = 0; i < size; ++i)
+    {
+        uniform.push_back(uniform_distribution(mt));
+        normal.push_back(normal_distribution(mt));
+    }
+
+    //Zipf with exponent 1.1: the probability of the value k is proportional to 1 / k^1.1.
+    std::vector<double> zipf_cdf(zipf_values);
+    double total = 0.0;
+    for (size_t k = 0; k < zipf_values; ++k)
+    {
+        total += 1.0 / std::pow(static_cast<double>(k + 1), 1.1);
+        zipf_cdf[k] = total;
+    }
+    std::uniform_real_distribution<double> zipf_distribution(0.0, total);
+    for (size_t i = 0; i < size; ++i)
+    {
+        zipf.push_back(static_cast<double>(std::lower_bound(zipf_cdf.begin(), zipf_cdf.end(), zipf_distribution(mt)) - zipf_cdf.begin() + 1));
+    }
+
+    const std::pair<const char*, const std::vector<double>*> inputs[] = { { "Uniform", &uniform }, { "Normal", &normal }, { "Zipf", &zipf } };
+    for (const auto& [name, input] : inputs)
+    {
+        std::vector<double> vector = *input;
+        Timer timer;
+        timer.Start();
+        Sort(vector.begin(), vector.end(), std::greater<double>());
+        const double default_time = timer.Stop();
+        bool sorted = CheckVector(vector);
+
+        vector = *input;
+        timer.Start();
+        Sort(vector.begin(), vector.end(), std::greater<double>(), SortAlgorithm::LearnedSort);
+        const double learned_time = timer.Stop();
+        sorted = sorted && CheckVector(vector);
+
+        std::vector<NormalizedKey<sizeof(double)>> keys(size);
+        timer.Start();
+        for (size_t i = 0; i < size; ++i)
+        {
+            KeyEncoder<sizeof(double)>(keys[i]).Add((*input)[i]);
+        }
+        NormalizedKeySort::RadixSort(keys.begin(), keys.end());
+        const double radix_time = timer.Stop();
+
+        std::cout << name << " doubles of size " << size << (sorted ? "" : " (Test failed!)") << std::endl;
+        std::cout << "\tDefault Sort:  " << std::fixed << std::setprecision(6) << default_time << " seconds" << std::endl;
+        std::cout << "\tLearned Sort:  " << std::fixed << std::setprecision(6) << learned_time << " seconds" << std::endl;
+        std::cout << "\tRadix Sort:    " << std::fixed << std::setprecision(6) << radix_time << " seconds" << std::endl;
+    }
+
+    //Discrete keys leave many buckets of the model empty.
+    constexpr size_t integer_size = size_t(1) << 20;
+    for (const std::uint32_t distinct : { 3000u, 4000u, 5000u, 8000u })
+    {
+        std::vector<std::uint32_t> integers(integer_size);
+        for (std::uint32_t& value : integers) { value = static_cast<std::uint32_t>(mt() % distinct); }
+        std::vector<std::uint32_t> expected = integers;
+        std::sort(expected.begin(), expected.end());
+        Sort(integers.begin(), integers.end(), std::greater<std::uint32_t>(), SortAlgorithm::LearnedSort);
+        std::cout << "Integers of size " << integer_size << " with " << distinct << " distinct values" << (integers == expected ? "" : " (Test failed!)") << std::endl;
+    }
+
+    //Integers above 2^53, where distinct values can be the same double. Most of them are spread and a cluster of close values fills a bucket by itself.
+    constexpr std::uint64_t cluster = std::uint64_t(1) << 61;
+    std::vector<std::uint64_t> large;
+    large.reserve(integer_size);
+    while (large.size() < integer_size)
+    {
+        const std::uint64_t value = mt() >> 2;
+        if (value > cluster - (cluster >> 3) && value < cluster + (cluster >> 3)) { continue; }
+        large.push_back(value);
+    }
+    for (size_t i = 0; i < integer_size / 128; ++i) { large[mt() % integer_size] = cluster + mt() % 3000; }
+    std::vector<std::uint64_t> expected = large;
+    std::sort(expected.begin(), expected.end());
+    Sort(large.begin(), large.end(), std::greater<std::uint64_t>(), SortAlgorithm::LearnedSort);
+    std::cout << "Integers above 2^53 of size " << integer_size << (large == expected ? "" : " (Test failed!)") << std::endl;
+}
+
+void Test::LazySortTest() noexcept
+{
+    constexpr size_t size = 10000000;
+    constexpr size_t page_size = 100;
+    constexpr size_t random_reads = 100;
+
+    std::mt19937_64 mt(std::random_device{}());
+    std::vector<size_t> input(size);
+    for (size_t& value : input) { value = mt(); }
+
+    std::vector<size_t> sorted_input = input;
+    Timer timer;
+    timer.Start();
+    Sort(sorted_input.begin(), sorted_input.end(), std::greater<size_t>());
+    const double sort_time = timer.Stop();
+    bool sorted = CheckVector(sorted_input);
+
+    //First page read in order.
+    std::vector<size_t> vector = input;
+    timer.Start();
+    LazySortedView<std::vector<size_t>::iterator, std::greater<size_t>> page_view(vector.begin(), vector.end(), std::greater<size_t>());
+    size_t checksum = 0;
+    for (size_t i = 0; i < page_size; ++i) { checksum += page_view[i]; }
+    const double page_time = timer.Stop();
+    for (size_t i = 0; i < page_size; ++i) { sorted = sorted && page_view[i] == sorted_input[i]; }
+
+    //Elements at random positions.
+    std::vector<size_t> indices(random_reads);
+    for (size_t& index : indices) { index = mt() % size; }
+    vector = input;
+    timer.Start();
+    LazySortedView<std::vector<size_t>::iterator, std::greater<size_t>> random_view(vector.begin(), vector.end(), std::greater<size_t>());
+    for (const size_t index : indices) { checksum += random_view[index]; }
+    const double random_time = timer.Stop();
+    for (const size_t index : indices) { sorted = sorted && random_view[index] == sorted_input[index]; }
+
+    //The whole view, which ends up sorting the whole container.
+    vector = input;
+    timer.Start();
+    LazySortedView<std::vector<size_t>::iterator, std::greater<size_t>> full_view(vector.begin(), vector.end(), std::greater<size_t>());
+    for (const size_t value : full_view) { checksum += value; }
+    const double full_time = timer.Stop();
+    sorted = sorted && vector == sorted_input && full_view.GetSortedPrefix() == size;
+
+    std::cout << "Lazy sorted view of size " << size << (sorted ? "" : " (Test failed!)") << " (checksum " << checksum << ")" << std::endl;
+    std::cout << "\tDefault Sort:                " << std::fixed << std::setprecision(6) << sort_time << " seconds" << std::endl;
+    std::cout << "\tFirst " << page_size << " elements:          " << std::fixed << std::setprecision(6) << page_time << " seconds" << std::endl;
+    std::cout << "\t" << random_reads << " random elements:         " << std::fixed << std::setprecision(6) << random_time << " seconds" << std::endl;
+    std::cout << "\tWhole view:                  " << std::fixed << std::setprecision(6) << full_time << " seconds" << std::endl;
+}
+
+void Test::SharedMemorySortTest() noexcept
+{
+    constexpr size_t size = 20000000;
+    constexpr size_t max_workers = 8;
+
+    std::mt19937_64 mt(std::random_device{}());
+    std::vector<size_t> input(size);
+    for (size_t& value : input) { value = mt(); }
+
+    std::vector<size_t> vector = input;
+    Timer timer;
+    timer.Start();
+    Sort(vector.begin(), vector.end(), std::greater<size_t>());
+    const double default_time = timer.Stop();
+    std::cout << "Shared memory sort of size " << size << (CheckVector(vector) ? "" : " (Test failed!)") << std::endl;
+    std::cout << "\tDefault Sort in this process: " << std::fixed << std::setprecision(6) << default_time << " seconds" << std::endl;
+
+    for (size_t workers = 1; workers <= max_workers; workers *= 2)
+    {
+        vector = input;
+        SharedSortReport report;
+        const bool shared = SharedMemorySort::Sort(vector.begin(), vector.end(), std::greater<size_t>(), workers, &report);
+        const bool sorted = CheckVector(vector);
+
+        std::cout << "\t" << workers << (workers == 1 ? " worker: " : " workers: ") << std::fixed << std::setprecision(6) << report.Total << " seconds";
+        if (!shared) { std::cout << " (workers not available, sorted in this process)"; }
+        std::cout << (sorted ? "" : " (Test failed!)") << std::endl;
+        if (report.Workers == 0) { continue; }
+        std::cout << "\t\tSetup: " << report.Setup << " Local sort: " << report.LocalSort << " Splitters: " << report.Splitters << " Exchange: " << report.Exchange
+            << " Merge: " << report.Merge << " Wait: " << report.Wait << " Collect: " << report.Collect << std::endl;
+    }
+}
+
 void Test::RunBubbleSortTest() noexcept
 {
     ClearFile("Bubble_Sort.txt");
@@ -267,6 +830,34 @@ void Test::RunDefaultSortTest() noexcept
     ExecuteTest(SortAlgorithm::Default, Type::Rotated);
 }
 
+void Test::RunLearnedSortTest() noexcept
+{
+    //Learned Sort only uses its model from 2^14 elements, so the sizes go up to 10^5 at least.
+    const size_t array_size = g_ARRAYSIZE;
+    g_ARRAYSIZE = std::max<size_t>(g_ARRAYSIZE, 5);
+    ClearFile("Learned_Sort.txt");
+    ExecuteTest(SortAlgorithm::LearnedSort, Type::Random);
+    ExecuteTest(SortAlgorithm::LearnedSort, Type::Front);
+    ExecuteTest(SortAlgorithm::LearnedSort, Type::Middle);
+    ExecuteTest(SortAlgorithm::LearnedSort, Type::Back);
+    ExecuteTest(SortAlgorithm::LearnedSort, Type::Reversed);
+    ExecuteTest(SortAlgorithm::LearnedSort, Type::Bitonic);
+    ExecuteTest(SortAlgorithm::LearnedSort, Type::Rotated);
+    g_ARRAYSIZE = array_size;
+}
+
+void Test::RunMergeInsertionSortTest() noexcept
+{
+    ClearFile("Merge_Insertion_Sort.txt");
+    ExecuteTest(SortAlgorithm::MergeInsertionSort, Type::Random);
+    ExecuteTest(SortAlgorithm::MergeInsertionSort, Type::Front);
+    ExecuteTest(SortAlgorithm::MergeInsertionSort, Type::Middle);
+    ExecuteTest(SortAlgorithm::MergeInsertionSort, Type::Back);
+    ExecuteTest(SortAlgorithm::MergeInsertionSort, Type::Reversed);
+    ExecuteTest(SortAlgorithm::MergeInsertionSort, Type::Bitonic);
+    ExecuteTest(SortAlgorithm::MergeInsertionSort, Type::Rotated);
+}
+
 void Test::ExecuteTest(SortAlgorithm algorithm, Test::Type test_type) noexcept
 {
     size_t vector_size = 1;
@@ -367,6 +958,16 @@ void Test::ExecuteTest(SortAlgorithm algorithm, Test::Type test_type) noexcept
             WriteResults("Quick Sort", type.c_str(), vector_size, sorted, best, average, worst);
             SerializeResults("Quick_Sort.txt");
             break;
+        case SortAlgorithm::LearnedSort:
+            WriteComparison("Learned Sort", type.c_str(), vector_size, best, average, worst);
+            WriteResults("Learned Sort", type.c_str(), vector_size, sorted, best, average, worst);
+            SerializeResults("Learned_Sort.txt");
+            break;
+        case SortAlgorithm::MergeInsertionSort:
+            WriteComparison("Merge Insertion Sort", type.c_str(), vector_size, best, average, worst);
+            WriteResults("Merge Insertion Sort", type.c_str(), vector_size, sorted, best, average, worst);
+            SerializeResults("Merge_Insertion_Sort.txt");
+            break;
         }
     }
 }
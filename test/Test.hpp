@@ -2,6 +2,7 @@
 
 #include "Sort.hpp"
 #include <vector>
+#include <iostream>
 
 class Test
 {
@@ -19,12 +20,24 @@ class Test
 public:
     static void RunAllTests() noexcept;
     static void QuickVSDefault() noexcept;
+    static void Autotune() noexcept;
+    static void SorterVSSort() noexcept;
+    static void SegmentedVSSort() noexcept;
+    static void LargeRecordTest() noexcept;
+    static void KWayMergeTest() noexcept;
+    static void SortReduceTest() noexcept;
+    static void NormalizedKeyTest() noexcept;
+    static void LearnedSortTest() noexcept;
+    static void LazySortTest() noexcept;
+    static void SharedMemorySortTest() noexcept;
     static void RunBubbleSortTest() noexcept;
     static void RunSelectionSortTest() noexcept;
     static void RunInsertionSortTest() noexcept;
     static void RunMergeSortTest() noexcept;
     static void RunQuickSortTest() noexcept;
     static void RunDefaultSortTest() noexcept;
+    static void RunLearnedSortTest() noexcept;
+    static void RunMergeInsertionSortTest() noexcept;
 
 private:
     template <typename T>
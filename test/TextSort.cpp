@@ -0,0 +1,613 @@
+#include "TextSort.hpp"
+#include "Sort.hpp"
+#include "NormalizedKey.hpp"
+
+#include <algorithm>    //For std::min and std::max
+#include <cstdio>       //For std::fprintf, std::fread, std::fwrite, std::fopen and std::rename
+#include <cstdlib>      //For std::strtoull and mkstemp
+#include <cstring>      //For std::memchr, std::memcmp and std::strcmp
+#include <thread>       //For std::thread::hardware_concurrency
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>    //For CreateFileA, CreateFileMappingA, MapViewOfFile and GetFileInformationByHandle
+#include <io.h>         //For _setmode and _fileno
+#include <fcntl.h>      //For _O_BINARY
+#else
+#include <fcntl.h>      //For open
+#include <sys/mman.h>   //For mmap and madvise
+#include <sys/stat.h>   //For stat, fstat and fchmod
+#include <sys/uio.h>    //For writev
+#include <unistd.h>     //For read, write, close, unlink and sysconf
+#include <climits>      //For IOV_MAX
+#endif
+
+static constexpr size_t s_MinChunkSize = size_t(1) << 20;       //Inputs are indexed in chunks of at least this size.
+static constexpr size_t s_ParallelGrain = size_t(1) << 16;
+static constexpr size_t s_OutputBufferSize = size_t(1) << 20;   //Buffered output, where vectored writes are not available.
+
+/*
+* Read only view of the whole input. Files are memory mapped. The standard input can not be mapped, so it is read to memory.
+*/
+class TextSort::MappedInput
+{
+public:
+    //copy reads the file to memory instead of mapping it, so the file can be replaced while it is used.
+    bool Open(const std::string& path, bool copy) noexcept
+    {
+        if (path.empty() || path == "-") { return ReadStandardInput(); }
+        if (copy) { return ReadFile(path); }
+
+#ifdef _WIN32
+        m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if (m_File == INVALID_HANDLE_VALUE) { return false; }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_File, &size)) { return false; }
+        m_Size = static_cast<size_t>(size.QuadPart);
+        if (m_Size == 0) { return true; }
+        m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_Mapping == nullptr) { return false; }
+        m_Data = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+        return m_Data != nullptr;
+#else
+        const int file = open(path.c_str(), O_RDONLY);
+        if (file < 0) { return false; }
+        struct stat status;
+        if (fstat(file, &status) != 0 || !S_ISREG(status.st_mode))
+        {
+            close(file);
+            return ReadFile(path);
+        }
+        m_Size = static_cast<size_t>(status.st_size);
+        if (m_Size != 0)
+        {
+            void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (data != MAP_FAILED)
+            {
+                //The sort reads the lines in random order, so the whole file is read ahead.
+                madvise(data, m_Size, MADV_WILLNEED);
+                m_Data = static_cast<const char*>(data);
+                m_Mapped = true;
+            }
+        }
+        close(file);
+        return m_Size == 0 || m_Mapped;
+#endif
+    }
+
+    const char* GetData() const noexcept { return m_Data; }
+    size_t GetSize() const noexcept { return m_Size; }
+
+public:
+    MappedInput() noexcept { }
+
+    ~MappedInput() noexcept
+    {
+#ifdef _WIN32
+        if (m_Data != nullptr && m_Buffer.empty()) { UnmapViewOfFile(m_Data); }
+        if (m_Mapping != nullptr) { CloseHandle(m_Mapping); }
+        if (m_File != INVALID_HANDLE_VALUE) { CloseHandle(m_File); }
+#else
+        if (m_Mapped) { munmap(const_cast<char*>(m_Data), m_Size); }
+#endif
+    }
+
+    MappedInput(const MappedInput&) = delete;
+    MappedInput& operator=(const MappedInput&) = delete;
+
+private:
+    bool ReadStandardInput() noexcept
+    {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        return ReadStream(stdin);
+    }
+
+    bool ReadFile(const std::string& path) noexcept
+    {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) { return false; }
+        const bool read = ReadStream(file);
+        std::fclose(file);
+        return read;
+    }
+
+    bool ReadStream(FILE* stream) noexcept
+    {
+        size_t read = 0;
+        m_Buffer.resize(s_OutputBufferSize);
+        while (true)
+        {
+            read += std::fread(m_Buffer.data() + read, 1, m_Buffer.size() - read, stream);
+            if (read < m_Buffer.size()) { break; }
+            m_Buffer.resize(m_Buffer.size() * 2);
+        }
+        m_Buffer.resize(read);
+        m_Data = m_Buffer.data();
+        m_Size = read;
+        return std::ferror(stream) == 0;
+    }
+
+private:
+    const char* m_Data = nullptr;
+    size_t m_Size = 0;
+    std::vector<char> m_Buffer;     //Input read instead of mapped.
+#ifdef _WIN32
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = nullptr;
+#else
+    bool m_Mapped = false;
+#endif
+};
+
+/*
+* Compares lines like the Sort comparators do: returns true if the first line goes after the second one.
+* The first key is compared by the prefixes and only if they are equal and the key is longer than the prefix, by its text.
+* The other keys are found in the text on every comparison.
+*/
+class TextSort::LineComparator
+{
+public:
+    LineComparator(const char* data, const Options& options) noexcept :
+        m_Data(data),
+        m_Options(options)
+    {
+    }
+
+    bool operator()(const Line& first, const Line& second) const noexcept
+    {
+        int result = CompareKeys(first, second);
+        if (result == 0)
+        {
+            if (!m_Options.Stable)
+            {
+                result = CompareText(m_Data + first.Offset, first.Length, m_Data + second.Offset, second.Length);
+                if (m_Options.Reverse) { result = -result; }
+            }
+            if (result == 0) { return first.Offset > second.Offset; }
+        }
+        return result > 0;
+    }
+
+    //Compares only the keys. Lines with equal keys are duplicates for -u.
+    int CompareKeys(const Line& first, const Line& second) const noexcept
+    {
+        const KeySpec& first_key = m_Options.Keys.front();
+        int result = 0;
+        if (first.Prefix != second.Prefix) { result = first.Prefix < second.Prefix ? -1 : 1; }
+        else if (!first_key.Numeric && (first.KeyLength > sizeof(first.Prefix) || second.KeyLength > sizeof(second.Prefix)))
+        {
+            result = CompareText(m_Data + first.Offset + first.KeyOffset, first.KeyLength, m_Data + second.Offset + second.KeyOffset, second.KeyLength);
+        }
+        if (first_key.Reverse) { result = -result; }
+
+        for (size_t i = 1; i < m_Options.Keys.size() && result == 0; ++i)
+        {
+            const KeySpec& key = m_Options.Keys[i];
+            const char* first_line = m_Data + first.Offset;
+            const char* second_line = m_Data + second.Offset;
+            size_t first_offset = 0;
+            size_t first_length = 0;
+            size_t second_offset = 0;
+            size_t second_length = 0;
+            FindKey(first_line, first.Length, key, m_Options.Delimiter, first_offset, first_length);
+            FindKey(second_line, second.Length, key, m_Options.Delimiter, second_offset, second_length);
+            if (key.Numeric)
+            {
+                const double first_value = ParseNumber(first_line + first_offset, first_length);
+                const double second_value = ParseNumber(second_line + second_offset, second_length);
+                result = first_value < second_value ? -1 : (second_value < first_value ? 1 : 0);
+            }
+            else
+            {
+                result = CompareText(first_line + first_offset, first_length, second_line + second_offset, second_length);
+            }
+            if (key.Reverse) { result = -result; }
+        }
+        return result;
+    }
+
+private:
+    static int CompareText(const char* first, size_t first_length, const char* second, size_t second_length) noexcept
+    {
+        const int result = std::memcmp(first, second, std::min(first_length, second_length));
+        if (result != 0) { return result; }
+        return first_length < second_length ? -1 : (first_length > second_length ? 1 : 0);
+    }
+
+private:
+    const char* m_Data;
+    const Options& m_Options;
+};
+
+int TextSort::Run(int argc, char** argv) noexcept
+{
+    Options options;
+    if (!ParseArguments(argc, argv, options))
+    {
+        std::fprintf(stderr, "Usage: %s [-k START[,END][n][r]]... [-t CHAR] [-n] [-r] [-u] [-s] [-o FILE] [--parallel=N] [FILE]\n", argv[0]);
+        return 2;
+    }
+
+    //-o may name the input. A mapped file can not be replaced on Windows, so there the input is read to memory,
+    //and elsewhere WriteLines writes to a temporary file that replaces the input once the output is complete.
+    const bool in_place = IsSameFile(options.Input, options.Output);
+#ifdef _WIN32
+    const bool copy_input = in_place;
+#else
+    const bool copy_input = false;
+#endif
+    MappedInput input;
+    if (!input.Open(options.Input, copy_input))
+    {
+        std::fprintf(stderr, "%s: can not read %s\n", argv[0], options.Input.empty() ? "standard input" : options.Input.c_str());
+        return 2;
+    }
+
+    //The pool has one thread less, the calling thread also works while it waits.
+    const size_t threads = options.Threads != 0 ? options.Threads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    SortThreadPool pool(threads - 1);
+    std::vector<Line> lines;
+    BuildIndex(input.GetData(), input.GetSize(), options, pool, lines);
+
+    const LineComparator comparator(input.GetData(), options);
+    SortConfiguration configuration = SortProfile::Get().Find(sizeof(Line));
+    if (threads > 1 && configuration.ParallelGrain == 0) { configuration.ParallelGrain = s_ParallelGrain; }
+    Sort(lines.begin(), lines.end(), comparator, SortAlgorithm::Default, configuration, nullptr, threads > 1 ? &pool : nullptr);
+
+    if (!WriteLines(input.GetData(), input.GetSize(), lines, comparator, options, in_place))
+    {
+        std::fprintf(stderr, "%s: can not write %s\n", argv[0], options.Output.empty() ? "standard output" : options.Output.c_str());
+        return 2;
+    }
+    return 0;
+}
+
+bool TextSort::ParseArguments(int argc, char** argv, Options& options) noexcept
+{
+    bool numeric = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (argument == "-k" && has_value)
+        {
+            KeySpec key;
+            if (!ParseKey(argv[++i], key)) { return false; }
+            options.Keys.push_back(key);
+        }
+        else if (argument == "-t" && has_value)
+        {
+            const std::string delimiter = argv[++i];
+            if (delimiter.size() != 1) { return false; }
+            options.Delimiter = delimiter[0];
+        }
+        else if (argument == "-o" && has_value) { options.Output = argv[++i]; }
+        else if (argument.compare(0, 11, "--parallel=") == 0) { options.Threads = std::strtoull(argument.c_str() + 11, nullptr, 10); }
+        else if (argument.size() > 1 && argument[0] == '-' && argument[1] != '-')
+        {
+            //Grouped flags, like -nru.
+            for (size_t j = 1; j < argument.size(); ++j)
+            {
+                switch (argument[j])
+                {
+                case 'n': numeric = true; break;
+                case 'r': options.Reverse = true; break;
+                case 'u': options.Unique = true; break;
+                case 's': options.Stable = true; break;
+                default: return false;
+                }
+            }
+        }
+        else if (options.Input.empty() && (argument == "-" || argument[0] != '-')) { options.Input = argument; }
+        else { return false; }
+    }
+
+    //Keys without their own order options use the global ones. Without keys, the whole line is the key.
+    //Unique keeps the first line of every group in input order, so it sorts stable.
+    if (options.Keys.empty()) { options.Keys.push_back(KeySpec()); }
+    if (options.Unique) { options.Stable = true; }
+    for (KeySpec& key : options.Keys)
+    {
+        if (!key.Numeric && !key.Reverse)
+        {
+            key.Numeric = numeric;
+            key.Reverse = options.Reverse;
+        }
+    }
+    return true;
+}
+
+//Parses START[,END][n][r].
+bool TextSort::ParseKey(const char* text, KeySpec& key) noexcept
+{
+    char* end = nullptr;
+    key.StartField = std::strtoull(text, &end, 10);
+    if (end == text || key.StartField == 0) { return false; }
+    if (*end == ',')
+    {
+        const char* end_field = end + 1;
+        key.EndField = std::strtoull(end_field, &end, 10);
+        if (end == end_field || key.EndField < key.StartField) { return false; }
+    }
+    for (; *end != '\0'; ++end)
+    {
+        if (*end == 'n') { key.Numeric = true; }
+        else if (*end == 'r') { key.Reverse = true; }
+        else { return false; }
+    }
+    return true;
+}
+
+/*
+* Splits the input in one chunk per thread, ending every chunk after a line break, and indexes the chunks in parallel.
+* The lines of every chunk are then appended in order.
+*/
+void TextSort::BuildIndex(const char* data, size_t size, const Options& options, SortThreadPool& pool, std::vector<Line>& lines) noexcept
+{
+    const size_t chunks_count = std::max<size_t>(std::min(pool.GetThreadCount() + 1, size / s_MinChunkSize), 1);
+    std::vector<size_t> bounds(1, 0);
+    for (size_t chunk = 1; chunk < chunks_count; ++chunk)
+    {
+        size_t bound = std::max(bounds.back(), chunk * size / chunks_count);
+        const void* line_break = bound < size ? std::memchr(data + bound, '\n', size - bound) : nullptr;
+        bound = line_break != nullptr ? static_cast<size_t>(static_cast<const char*>(line_break) - data) + 1 : size;
+        bounds.push_back(bound);
+    }
+    bounds.push_back(size);
+
+    struct IndexJob
+    {
+        const char* Data;
+        const Options* Settings;
+        const std::vector<size_t>* Bounds;
+        std::vector<std::vector<Line>> Chunks;
+    };
+    IndexJob job{ data, &options, &bounds, std::vector<std::vector<Line>>(chunks_count) };
+    const auto index_task = [](void* context, size_t chunk, size_t)
+    {
+        IndexJob& index_job = *static_cast<IndexJob*>(context);
+        IndexChunk(index_job.Data, (*index_job.Bounds)[chunk], (*index_job.Bounds)[chunk + 1], *index_job.Settings, index_job.Chunks[chunk]);
+    };
+
+    SortThreadPool::TaskGroup group;
+    for (size_t chunk = 1; chunk < chunks_count; ++chunk)
+    {
+        pool.Submit(group, index_task, &job, chunk, 0);
+    }
+    index_task(&job, 0, 0);
+    pool.Wait(group);
+
+    size_t count = 0;
+    for (const std::vector<Line>& chunk : job.Chunks) { count += chunk.size(); }
+    lines.clear();
+    lines.reserve(count);
+    for (const std::vector<Line>& chunk : job.Chunks) { lines.insert(lines.end(), chunk.begin(), chunk.end()); }
+}
+
+void TextSort::IndexChunk(const char* data, size_t begin, size_t end, const Options& options, std::vector<Line>& lines) noexcept
+{
+    const KeySpec& key = options.Keys.front();
+    lines.reserve((end - begin) / 64);
+    while (begin < end)
+    {
+        const void* line_break = std::memchr(data + begin, '\n', end - begin);
+        const size_t line_end = line_break != nullptr ? static_cast<size_t>(static_cast<const char*>(line_break) - data) : end;
+
+        Line line;
+        line.Offset = begin;
+        line.Length = line_end - begin;
+        size_t key_offset = 0;
+        size_t key_length = 0;
+        FindKey(data + begin, line.Length, key, options.Delimiter, key_offset, key_length);
+        line.KeyOffset = key_offset;
+        line.KeyLength = key_length;
+
+        //Numeric keys are stored whole, lexical keys by their first bytes.
+        NormalizedKey<sizeof(line.Prefix)> prefix;
+        KeyEncoder<sizeof(line.Prefix)> encoder(prefix);
+        if (key.Numeric) { encoder.Add(ParseNumber(data + begin + key_offset, key_length)); }
+        else { encoder.Add(std::string_view(data + begin + key_offset, key_length), sizeof(line.Prefix)); }
+        line.Prefix = 0;
+        for (const unsigned char byte : prefix.Bytes) { line.Prefix = (line.Prefix << 8) | byte; }
+
+        lines.push_back(line);
+        begin = line_end + 1;
+    }
+}
+
+//Without delimiter a field is a run of blanks followed by a run of other characters, so keys keep their leading blanks like sort without -b does.
+void TextSort::FindKey(const char* line, size_t length, const KeySpec& key, char delimiter, size_t& key_offset, size_t& key_length) noexcept
+{
+    const auto is_blank = [](char character) { return character == ' ' || character == '\t'; };
+
+    //Moves position from the start of a field to its end.
+    const auto skip_field = [&](size_t& position)
+    {
+        if (delimiter != 0)
+        {
+            while (position < length && line[position] != delimiter) { ++position; }
+            return;
+        }
+        while (position < length && is_blank(line[position])) { ++position; }
+        while (position < length && !is_blank(line[position])) { ++position; }
+    };
+
+    //Moves position from the end of a field to the start of the next one.
+    const auto skip_delimiter = [&](size_t& position)
+    {
+        if (delimiter != 0 && position < length) { ++position; }
+    };
+
+    size_t start = 0;
+    for (size_t field = 1; field < key.StartField; ++field)
+    {
+        skip_field(start);
+        skip_delimiter(start);
+    }
+
+    size_t end = length;
+    if (key.EndField != 0)
+    {
+        end = start;
+        skip_field(end);
+        for (size_t field = key.StartField; field < key.EndField; ++field)
+        {
+            skip_delimiter(end);
+            skip_field(end);
+        }
+    }
+    key_offset = start;
+    key_length = end - start;
+}
+
+//Reads an optional minus sign, digits and an optional decimal part, skipping the leading blanks. Anything else ends the number.
+double TextSort::ParseNumber(const char* text, size_t length) noexcept
+{
+    size_t i = 0;
+    while (i < length && (text[i] == ' ' || text[i] == '\t')) { ++i; }
+    const bool negative = i < length && text[i] == '-';
+    if (negative) { ++i; }
+
+    double value = 0.0;
+    for (; i < length && text[i] >= '0' && text[i] <= '9'; ++i) { value = value * 10.0 + (text[i] - '0'); }
+    if (i < length && text[i] == '.')
+    {
+        //The decimal digits are read as an integer and divided once, so numbers with more digits never read smaller.
+        double decimals = 0.0;
+        double scale = 1.0;
+        for (++i; i < length && text[i] >= '0' && text[i] <= '9'; ++i)
+        {
+            decimals = decimals * 10.0 + (text[i] - '0');
+            scale *= 10.0;
+        }
+        value += decimals / scale;
+    }
+
+    //-0 is 0, the NormalizedKey of -0.0 would go before it.
+    return negative && value != 0.0 ? -value : value;
+}
+
+/*
+* Writes the lines in order, skipping the duplicates if the option is set. Lines are written straight from the input with their line break,
+* and consecutive lines that are also consecutive in the input are written as a single block.
+*/
+bool TextSort::WriteLines(const char* data, size_t size, const std::vector<Line>& lines, const LineComparator& comparator, const Options& options, bool in_place) noexcept
+{
+    static const char s_LineBreak = '\n';
+    const Line* previous = nullptr;
+
+#ifdef _WIN32
+    //The input was read to memory, so the output can replace it directly.
+    static_cast<void>(in_place);
+    FILE* file = stdout;
+    if (!options.Output.empty()) { file = std::fopen(options.Output.c_str(), "wb"); }
+    else { _setmode(_fileno(stdout), _O_BINARY); }
+    if (file == nullptr) { return false; }
+    std::vector<char> buffer(s_OutputBufferSize);
+    std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+    bool written = true;
+    for (const Line& line : lines)
+    {
+        if (options.Unique && previous != nullptr && comparator.CompareKeys(*previous, line) == 0) { continue; }
+        previous = &line;
+        written = written && std::fwrite(data + line.Offset, 1, line.Length, file) == line.Length && std::fwrite(&s_LineBreak, 1, 1, file) == 1;
+    }
+    if (file != stdout) { written = std::fclose(file) == 0 && written; }
+    else { written = std::fflush(file) == 0 && written; }
+    return written;
+#else
+    //Truncating the input would empty the mapping the lines are read from, so the output goes to a temporary file in the same directory, which keeps the rename atomic.
+    std::string temporary;
+    int file = STDOUT_FILENO;
+    if (in_place)
+    {
+        temporary = options.Output + ".XXXXXX";
+        file = mkstemp(temporary.data());
+        struct stat status;
+        if (file >= 0 && stat(options.Output.c_str(), &status) == 0) { fchmod(file, status.st_mode & 07777); }
+    }
+    else if (!options.Output.empty()) { file = open(options.Output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644); }
+    if (file < 0) { return false; }
+
+    std::vector<iovec> blocks;
+    blocks.reserve(IOV_MAX);
+    bool written = true;
+    const auto flush = [&]()
+    {
+        size_t first = 0;
+        while (written && first < blocks.size())
+        {
+            ssize_t bytes = writev(file, blocks.data() + first, static_cast<int>(blocks.size() - first));
+            if (bytes < 0) { written = false; break; }
+            //Partial write: skip the blocks written and trim the first one not fully written.
+            while (first < blocks.size() && static_cast<size_t>(bytes) >= blocks[first].iov_len) { bytes -= blocks[first].iov_len; ++first; }
+            if (first < blocks.size())
+            {
+                blocks[first].iov_base = static_cast<char*>(blocks[first].iov_base) + bytes;
+                blocks[first].iov_len -= bytes;
+            }
+        }
+        blocks.clear();
+    };
+
+    for (const Line& line : lines)
+    {
+        if (options.Unique && previous != nullptr && comparator.CompareKeys(*previous, line) == 0) { continue; }
+        previous = &line;
+
+        //The last line of the input may have no line break.
+        const bool has_line_break = line.Offset + line.Length < size;
+        char* begin = const_cast<char*>(data + line.Offset);
+        const size_t length = line.Length + (has_line_break ? 1 : 0);
+        if (!blocks.empty() && static_cast<char*>(blocks.back().iov_base) + blocks.back().iov_len == begin) { blocks.back().iov_len += length; }
+        else
+        {
+            if (blocks.size() == IOV_MAX) { flush(); }
+            blocks.push_back({ begin, length });
+        }
+        if (!has_line_break)
+        {
+            if (blocks.size() == IOV_MAX) { flush(); }
+            blocks.push_back({ const_cast<char*>(&s_LineBreak), 1 });
+        }
+    }
+    flush();
+    if (file != STDOUT_FILENO) { written = close(file) == 0 && written; }
+    if (!temporary.empty())
+    {
+        written = written && std::rename(temporary.c_str(), options.Output.c_str()) == 0;
+        if (!written) { unlink(temporary.c_str()); }
+    }
+    return written;
+#endif
+}
+
+bool TextSort::IsSameFile(const std::string& first, const std::string& second) noexcept
+{
+    if (first.empty() || first == "-" || second.empty()) { return false; }
+
+#ifdef _WIN32
+    //Paths can differ for the same file, so the files are compared by their volume and index.
+    BY_HANDLE_FILE_INFORMATION information[2];
+    const std::string* paths[2] = { &first, &second };
+    for (size_t i = 0; i < 2; ++i)
+    {
+        const HANDLE file = CreateFileA(paths[i]->c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) { return false; }
+        const bool found = GetFileInformationByHandle(file, &information[i]) != 0;
+        CloseHandle(file);
+        if (!found) { return false; }
+    }
+    return information[0].dwVolumeSerialNumber == information[1].dwVolumeSerialNumber &&
+        information[0].nFileIndexHigh == information[1].nFileIndexHigh && information[0].nFileIndexLow == information[1].nFileIndexLow;
+#else
+    //Paths can differ for the same file, so the files are compared by their device and inode.
+    struct stat first_status;
+    struct stat second_status;
+    if (stat(first.c_str(), &first_status) != 0 || stat(second.c_str(), &second_status) != 0) { return false; }
+    return first_status.st_dev == second_status.st_dev && first_status.st_ino == second_status.st_ino;
+#endif
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+/*
+* Author: Luis Poveda Cano.
+* luispovedacano@gmail.com
+*/
+
+/*
+* Line oriented text sorter, run by the console application unless it gets --run-tests or --benchmark.
+*
+* Usage: Sort [options] [file]
+* -k START[,END][n][r]  Sort by the fields START to END (1 based, END defaults to the end of the line). Can be repeated, later keys break the ties of earlier ones.
+* -t CHAR               Field delimiter. By default a field is a run of blanks followed by the characters up to the next blank, so keys keep their leading blanks.
+* -n                    Numeric order: the key is read as leading blanks, an optional minus sign, digits and an optional decimal part. Anything else reads as 0.
+* -r                    Reverse order.
+* -u                    Output only the first line, in input order, of every group of lines with equal keys. Implies -s.
+* -s                    Stable: lines with equal keys keep their input order instead of being compared whole.
+* -o FILE               Output file. Standard output by default.
+* --parallel=N          Threads used to index and sort. All the hardware threads by default.
+* Without file, or with -, the standard input is read. Without keys the whole line is the key. Lines are compared byte by byte, like sort with LC_ALL=C,
+* and lines with equal keys are ordered by the whole line unless -s is given.
+*
+* The input file is memory mapped and never copied: every line is indexed by its offset, its length, where its first key is and the first 8 bytes of that key
+* (or the key itself for numeric keys) encoded as a NormalizedKey, so most comparisons are one integer comparison without touching the text.
+* The index is built in parallel chunks and sorted by Default Sort with a SortThreadPool. The output is written with vectored writes straight from the mapped file.
+*/
+
+/*
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Copyright (c) 2021 Luis Poveda Cano
+*/
+
+#include "SortThreadPool.hpp"
+#include <cstddef>  //For size_t
+#include <cstdint>  //For std::uint64_t
+#include <string>   //For std::string
+#include <vector>   //For std::vector
+
+class TextSort
+{
+public:
+    //Sorts as the arguments say. Returns the process exit code: 0 on success, 2 on bad arguments or input and output errors.
+    static int Run(int argc, char** argv) noexcept;
+
+private:
+    struct KeySpec
+    {
+        size_t StartField = 1;
+        size_t EndField = 0;    //0 means the end of the line.
+        bool Numeric = false;
+        bool Reverse = false;
+    };
+
+    struct Options
+    {
+        std::vector<KeySpec> Keys;
+        char Delimiter = 0;     //0 means runs of blanks.
+        bool Unique = false;
+        bool Stable = false;
+        bool Reverse = false;   //Reverse order of the whole line comparison that breaks the ties of the keys.
+        size_t Threads = 0;
+        std::string Input;
+        std::string Output;
+    };
+
+    //A line of the input. Offsets are relative to the beginning of the input and the first key is relative to the line.
+    struct Line
+    {
+        std::uint64_t Prefix;   //First key encoded so that comparing prefixes compares the keys.
+        size_t Offset;
+        size_t Length;          //Without the line break.
+        size_t KeyOffset;
+        size_t KeyLength;
+    };
+
+    class LineComparator;
+    class MappedInput;
+
+private:
+    static bool ParseArguments(int argc, char** argv, Options& options) noexcept;
+    static bool ParseKey(const char* text, KeySpec& key) noexcept;
+    static void BuildIndex(const char* data, size_t size, const Options& options, SortThreadPool& pool, std::vector<Line>& lines) noexcept;
+    static void IndexChunk(const char* data, size_t begin, size_t end, const Options& options, std::vector<Line>& lines) noexcept;
+    //in_place means the output is the input, so it can not be truncated while the input is read.
+    static bool WriteLines(const char* data, size_t size, const std::vector<Line>& lines, const LineComparator& comparator, const Options& options, bool in_place) noexcept;
+    static bool IsSameFile(const std::string& first, const std::string& second) noexcept;
+
+    //Where the key starts in the line and its length.
+    static void FindKey(const char* line, size_t length, const KeySpec& key, char delimiter, size_t& key_offset, size_t& key_length) noexcept;
+    static double ParseNumber(const char* text, size_t length) noexcept;
+};
@@ -41,12 +41,12 @@ class Timer
 public:
     void Start() noexcept
     {
-        m_StartTime = std::chrono::high_resolution_clock::now();
+        m_StartTime = std::chrono::steady_clock::now();
     }
 
     double Stop() noexcept
     {
-        std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - m_StartTime;
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - m_StartTime;
         return duration.count();
     }
 